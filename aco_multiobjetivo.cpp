@@ -1,140 +1,204 @@
 
 #include <iostream>
+#include <cassert>
+#include <utility>
+#include <algorithm>
+#include <mutex>
 #include "aco_multiobjetivo.h"
+#include "ant_scratch.h"
+#include "pheromone_scan.h"
+#include "lazy_evaporation.h"
+#include "graph_updates.h"
+#include "counter_rng.h"
 
 
 namespace AnCO {
 
     namespace algorithm {
 
-        std::map<std::string, std::pair<int, float>> aco_multiobjetivo::objective_list;
+        namespace {
+            thread_local const objective_set* current_objectives = nullptr;
+            thread_local const std::atomic<bool>* current_stop = nullptr;
+            std::ostream* trace_stream = &std::cout;
+
+            // Matriz (objetivos x edges) contigua: se rellena fila a fila en orden de prioridad y
+            //  se para en la primera fila con algn valor por encima del umbral.
+            template <typename EdgeAt>
+            pheromone_pick pick_edge(EdgeAt edge_at, std::size_t n, const objective_set& objetivos, std::size_t n_objetivos, std::vector<float>& matrix) {
+                pheromone_pick pick = {n_objetivos, n, 0.f};
+                matrix.resize(n_objetivos*n);
+                // Evaporacin pendiente de estos edges (si es 'lazy')
+                if (lazy_evaporation* evaporation = lazy_evaporation::current()) {
+                    for (std::size_t e = 0; e<n; ++e) {
+                        evaporation->touch(edge_at(e));
+                        }
+                    }
+                for (std::size_t oo = 0; oo<n_objetivos; ++oo) {
+                    float* row = matrix.data() + oo*n;
+                    const unsigned int pherom_id = objetivos[oo].pherom_id;
+                    for (std::size_t e = 0; e<n; ++e) {
+                        row[e] = edge_at(e)->data.pheromone[pherom_id];
+                        }
+                    float value;
+                    std::size_t e = pheromone_row_argmax(row, n, pheromone_threshold, value);
+                    if (e < n) {
+                        pick.objective = oo;
+                        pick.edge = e;
+                        pick.value = value;
+                        break;
+                        }
+                    }
+                return pick;
+                }
+            }
+
+        aco_multiobjetivo::objective_scope::objective_scope(const objective_set::_t_ptr& objectives) : previous(current_objectives) {
+            current_objectives = objectives.get();
+            }
+
+        aco_multiobjetivo::objective_scope::~objective_scope() {
+            current_objectives = previous;
+            }
+
+        aco_multiobjetivo::stop_scope::stop_scope(const std::atomic<bool>* stop) : previous(current_stop) {
+            current_stop = stop;
+            }
+
+        aco_multiobjetivo::stop_scope::~stop_scope() {
+            current_stop = previous;
+            }
+
+        bool aco_multiobjetivo::stopped() {
+            return current_stop && current_stop->load(std::memory_order_relaxed);
+            }
+
+        const objective_set& aco_multiobjetivo::objectives() {
+            assert(current_objectives != nullptr);
+            return *current_objectives;
+            }
+
+        void aco_multiobjetivo::set_trace(std::ostream* os) {
+            trace_stream = os;
+            }
 
-        void print_path(aco_multiobjetivo::_t_ant_path::iterator begin, aco_multiobjetivo::_t_ant_path::iterator end) {
-            std::cout << (*begin)->init;
+        void print_path(std::ostream& os, aco_multiobjetivo::_t_ant_path::iterator begin, aco_multiobjetivo::_t_ant_path::iterator end) {
+            os << (*begin)->init;
             for (auto it = begin; it!=end; ++it) {
-                std::cout << " -> " << (*it)->end;
+                os << " -> " << (*it)->end;
                 }            
             };
   
 
         // La eleccin de los edges est condicionada a los objetivos...
-        edge_ptr aco_multiobjetivo::select_edge(const std::vector<edge_ptr>& feasible_edges, const unsigned int& pherom_id, std::vector<std::pair<std::string, int>>& objetivos) {
+        std::size_t aco_multiobjetivo::select_edge(ant_scratch& scratch, const unsigned int& pherom_id) {
             // La eleccin de los edges tiene en cuenta lo siguiente (en este orden):
             // 1) Buscamos la feromona de alguno de los objetivos futuros
             // 2) Si tenemos un objetivo, caminamos en feromona ascendente
             // 3) Si no tenemos objetivo, random select.
 
-            edge_ptr next;
-            std::pair<int, float> next_metrics = std::make_pair(objetivos.size(), 0.f);
+            const std::vector<edge_ptr>& feasible_edges = scratch.feasible;
 
             // 1-2) Elegimos el camino que nos lleva hacia el mximo de feromona de alguno de nuestros objetivos en orden de prioridad
-            for (auto fe = feasible_edges.begin(); fe != feasible_edges.end(); ++fe) {
-                int obj_index = objetivos.size();
-                //int pheromon = GLOBALS::n_colonies;
-                for ( auto oo = 0; oo<obj_index; ++oo) {
-                    float pheromon_value = (*fe)->data.pheromone[oo];
-                    if ( pheromon_value > 0.01f) {
-                        if ((oo < next_metrics.first) || ( (oo==next_metrics.first) && ( pheromon_value > next_metrics.second ) )) {
-                            next = *fe;
-                            next_metrics = std::make_pair(oo, pheromon_value);
-                            break;
-                            }
-                        }
-                    }
-                }
+            pheromone_pick pick = pick_edge([&feasible_edges](std::size_t e){ return feasible_edges[e].get(); }, feasible_edges.size(), *scratch.objectives, scratch.n_objetivos, scratch.pheromone);
 
-            if (next) {
+            if (pick.edge < feasible_edges.size()) {
                 // Elimino todos los objetivos menos prioritarios que el que he encontrado
-                objetivos.erase(objetivos.begin() + next_metrics.first + 1, objetivos.end());
+                scratch.n_objetivos = pick.objective + 1;
                 // Elimino este objetivo si he llegado al nodo central del hormiguero
-                if (objetivos[next_metrics.first].first == next->end) {
-                    objetivos.erase(objetivos.begin() + next_metrics.first - 1);
+                if (scratch.reached(pick.objective, scratch.feasible_index[pick.edge])) {
+                    scratch.n_objetivos = pick.objective;
                     }
+                return pick.edge;
                 }
-            else {
-                next = aco_mmas::select_edge(feasible_edges, pherom_id);
-                }
-            return next;
+            // 3) Regla de MMAS; usa el generador de la librera, compartido con las colonias de otros hilos
+            std::lock_guard<std::recursive_mutex> lock(library_rng_mutex());
+            const edge_ptr next = aco_mmas::select_edge(feasible_edges, pherom_id);
+            return std::find(feasible_edges.begin(), feasible_edges.end(), next) - feasible_edges.begin();
             }
 
         void aco_multiobjetivo::select_paths(std::vector<std::pair<_t_ant_path, bool>>& tmp_paths) {
 
             // Selecciono el camino que ms lejos haya llegado (el que ms haya conseguido puntuar)
-            //      static std::map<std::string, float> objective_list;
-
-            // Creamos una lista de objetivos (primero el ltimo, el ms prioritario)
-            std::vector<std::pair<std::string, int>> objetivos;
-            for (auto oo = objective_list.rbegin(); oo != objective_list.rend(); ++oo) {
-                objetivos.push_back( std::make_pair(oo->first, oo->second.first));
-                }
-
-            _t_ant_path selected;
-            std::pair<int, float> selected_metric = std::make_pair(objetivos.size(), 0.f);
-            std::vector<std::pair<_t_ant_path, bool>> selected_paths;
-                       
+            ant_scratch& scratch = ant_scratch::local();
+            assert(graph_index::current() != nullptr);
+            scratch.bind(*graph_index::current());
+            scratch.load_objectives(objectives());
+
+            // Los caminos se mueven (y se recortan en su sitio), nunca se copian
+            std::vector<std::pair<_t_ant_path, bool>>& selected_paths = scratch.selected_paths;
+            selected_paths.clear();
+
+            // Los edges de todos los caminos que no han llegado se puntan juntos (en el orden en que aparecen)
+            scratch.candidates.clear();
+            scratch.owners.clear();
             for (auto it=tmp_paths.begin(); it!=tmp_paths.end(); ++it) {
-                if ( (*it->first.rbegin())->end == (objetivos.begin()->first)) {
-                    std::cout << std::endl << "\t\t FOUND (" << it->first.size() << "): "; print_path(it->first.begin(), it->first.end()); std::cout << std::endl;
-                    selected_paths.push_back( std::make_pair(it->first, true) );
+                if (it->first.empty()) {
+                    continue; // hormiga detenida antes de dar un paso ('stop_scope')
+                    }
+                if (scratch.reached(0, scratch.end(*it->first.rbegin()))) {
+                    if (trace_stream) {
+                        *trace_stream << std::endl << "\t\t FOUND (" << it->first.size() << "): "; print_path(*trace_stream, it->first.begin(), it->first.end()); *trace_stream << std::endl;
+                        }
+                    selected_paths.push_back( std::make_pair(std::move(it->first), true) );
                     }
                 else {
-                    int obj_index = objetivos.size();
-                    for (auto jj = it->first.begin(); jj != it->first.end(); ++jj) {
-                        for ( auto oo = 0; oo<obj_index; ++oo) {
-                            float pheromon_value = (*jj)->data.pheromone[oo];
-                            if ( pheromon_value > 0.01f) {
-                                if ((oo < selected_metric.first) || ( (oo==selected_metric.first) && ( pheromon_value > selected_metric.second ) )) {
-                                    selected = _t_ant_path(it->first.begin(), jj);
-                                    selected_metric = std::make_pair(oo, pheromon_value);
-                                    break;
-                                    }
-                                }
-                            }
+                    for (std::size_t jj = 0; jj<it->first.size(); ++jj) {
+                        scratch.candidates.push_back(it->first[jj].get());
+                        scratch.owners.push_back(std::make_pair(std::size_t(it - tmp_paths.begin()), jj));
                         }
                     }
                 }
-            
-            tmp_paths.clear();
-            if (selected_metric.second != 0.f) {
+            const std::vector<const ant_scratch::_t_edge*>& candidates = scratch.candidates;
+            pheromone_pick pick = pick_edge([&candidates](std::size_t e){ return candidates[e]; }, candidates.size(), *scratch.objectives, scratch.n_objetivos, scratch.pheromone);
+            std::pair<int, float> selected_metric = std::make_pair(int(pick.objective), pick.value);
+            if (pick.edge < candidates.size() && selected_metric.second != 0.f) {
+                _t_ant_path& selected = tmp_paths[scratch.owners[pick.edge].first].first;
+                selected.erase(selected.begin() + scratch.owners[pick.edge].second, selected.end());
                 //std::cout << std::endl << "\t\t obj [" << selected_metric.first  << "]: "; print_path(selected.begin(), selected.end()); std::cout << std::endl;
-                selected_paths.push_back(std::make_pair(selected, false));
+                selected_paths.push_back(std::make_pair(std::move(selected), false));
                 }
-            tmp_paths = selected_paths;
+            tmp_paths.swap(selected_paths);
             }
 
         // IDEM ACO_MMAS
         bool aco_multiobjetivo::run(graph& graph, const graph::_t_node_id& node, const unsigned int& pherom_id, _f_success& suc, std::vector<edge_ptr>& _path, const int& max_steps) {
-            // Creamos una lista de objetivos (primero el ltimo, el ms prioritario)
-            std::vector<std::pair<std::string, int>> objetivos;
-            for (auto oo = objective_list.rbegin(); oo != objective_list.rend(); ++oo) {
-                objetivos.push_back( std::make_pair(oo->first, oo->second.first));
+            // Memoria de trabajo reutilizada por todas las hormigas de este hilo (sin reservas en el bucle)
+            ant_scratch& scratch = ant_scratch::local();
+            assert(graph_index::current() != nullptr);
+            scratch.bind(*graph_index::current());
+            scratch.new_ant();
+            scratch.load_objectives(objectives());
+
+            const graph::_t_node_id* current_node = &node;
+            ant_scratch::_t_index current = scratch.index(node);
+            if (current == graph_index::npos) {
+                return false; // not a node of this graph
                 }
-
-            std::set<graph::_t_node_id> visited;
-            graph::_t_node_id current_node = node;
-            visited.insert(current_node);
+            scratch.visit(current);
             int step = 0;
-            edge_ptr edge;
             bool succeeded = false;
-            do {
-                // 1) Calcular los edges que son posibles
-                std::vector<edge_ptr> feasible_edges;
-                int n = aco_multiobjetivo::get_feasible_edges(graph, current_node, feasible_edges, visited);
-                if (n == 0) {
+            while (!aco_multiobjetivo::stopped()) {
+                // 1) Calcular los edges que son posibles (tambin los insertados en el grafo vivo)
+                scratch.collect_feasible(graph, *current_node, current);
+                if (scratch.feasible.empty()) {
                     break; // break. No more nodes to visit.
                     }
 
                 // 2) Elegir uno
-                edge_ptr edge = aco_multiobjetivo::select_edge(feasible_edges, pherom_id, objetivos);
+                const std::size_t next = aco_multiobjetivo::select_edge(scratch, pherom_id);
+                const edge_ptr& edge = scratch.feasible[next];
                 
                 // 3) Aadir al path y actualizar variables.
                 _path.push_back(edge);
-                current_node = edge->end;
-                visited.insert(current_node);
-                succeeded = suc(edge) || !objetivos.size();
+                current_node = &edge->end;
+                current = scratch.feasible_index[next];
+                scratch.visit(current);
+                succeeded = suc(edge) || !scratch.n_objetivos;
                 ++step;
+                if (succeeded || step>=max_steps) {
+                    break;
+                    }
                 }
-            while(!succeeded && step<max_steps);
             return succeeded;
             } 
 
@@ -1,9 +1,13 @@
 
 #pragma once
 
+#include <ostream>
+#include <atomic>
+
 #include "jgsogo/AnCO/algorithm/aco_mmas.h"
 //#include "jgsogo/AnCO/colony/success.h"
 #include "jgsogo/AnCO/graph/graph.h"
+#include "objective_set.h"
 
 namespace AnCO {
 
@@ -19,10 +23,13 @@ namespace AnCO {
 
     namespace algorithm {
 
+        class ant_scratch;
+
         class aco_multiobjetivo : public aco_mmas {
             public:
                 static void select_paths(std::vector<std::pair<_t_ant_path, bool>>& tmp_paths);
-                static edge_ptr select_edge(const std::vector<edge_ptr>& feasible_edges, const unsigned int& pherom_id, std::vector<std::pair<std::string, int>>& objetivos);
+                // Posicin en 'scratch.feasible' del edge elegido (poda los objetivos pendientes de 'scratch')
+                static std::size_t select_edge(ant_scratch& scratch, const unsigned int& pherom_id);
 
                 // Ejecucin del algoritmo
                 static bool run(    /*const*/ graph& graph,         // [in] grafo en el que me muevo
@@ -32,7 +39,36 @@ namespace AnCO {
                                     std::vector<edge_ptr>& _path,   // [out] camino seguido
                                     const int& max_steps = 100);    // [in] nmero mximo de pasos
 
-                static std::map<std::string, std::pair<int, float>> objective_list; //! TODO:  lista de objetivos con puntuacin e identificacin de feromona, por supuesto esto no puede ser static!!!
+                // Los objetivos no son static: cada hilo trabaja con los de la bsqueda que tenga activa.
+                //  'run' y 'select_paths' (llamadas desde colony::run y colony::update) leen el
+                //  'objective_set' que haya instalado el 'objective_scope' de ese hilo.
+                class objective_scope {
+                    public:
+                        objective_scope(const objective_set::_t_ptr& objectives);
+                        ~objective_scope();
+                    private:
+                        objective_scope(const objective_scope&);
+                        objective_scope& operator=(const objective_scope&);
+                        const objective_set* previous;
+                    };
+                static const objective_set& objectives();
+
+                // Mientras el 'stop_scope' de un hilo est instalado, sus hormigas abandonan el camino en cuanto
+                //  '*stop' es true (p.ej. otra colonia de la carrera ya tiene un camino dentro de la cota).
+                class stop_scope {
+                    public:
+                        stop_scope(const std::atomic<bool>* stop);
+                        ~stop_scope();
+                    private:
+                        stop_scope(const stop_scope&);
+                        stop_scope& operator=(const stop_scope&);
+                        const std::atomic<bool>* previous;
+                    };
+                static bool stopped();
+
+                // Donde se escriben los caminos encontrados (std::cout por defecto, nullptr para no escribirlos);
+                //  se fija al arrancar, antes de lanzar ninguna hormiga.
+                static void set_trace(std::ostream* os);
 
             };
 
@@ -0,0 +1,79 @@
+
+#include "aco_random_streams.h"
+
+#include <set>
+
+#include "ant_scratch.h"
+#include "graph_index.h"
+#include "graph_updates.h"
+
+namespace AnCO {
+
+    namespace algorithm {
+
+        bool aco_random_streams::run(graph& graph, const graph::_t_node_id& node, const unsigned int& pherom_id,
+                                     _f_success& suc, std::vector<edge_ptr>& _path, const int& max_steps) {
+            counter_rng rng = random_streams::ant(pherom_id);
+            ant_scratch& scratch = ant_scratch::local();
+            const graph_index* index = graph_index::current();
+            int step = 0;
+            bool succeeded = false;
+
+            if (index && index->indexes(graph)) {
+                scratch.bind(*index);
+                scratch.new_ant();
+                const graph::_t_node_id* current_node = &node;
+                ant_scratch::_t_index current = scratch.index(node);
+                if (current == graph_index::npos) {
+                    return false; // not a node of this graph
+                    }
+                scratch.visit(current);
+                do {
+                    scratch.collect_feasible(graph, *current_node, current);
+                    if (scratch.feasible.empty()) {
+                        break;
+                        }
+                    rng.at(std::uint32_t(step));
+                    const std::size_t next = rng.below(std::uint32_t(scratch.feasible.size()));
+                    const edge_ptr& edge = scratch.feasible[next];
+                    _path.push_back(edge);
+                    current_node = &edge->end;
+                    current = scratch.feasible_index[next];
+                    scratch.visit(current);
+                    succeeded = suc(edge);
+                    ++step;
+                    }
+                while (!succeeded && step<max_steps);
+                return succeeded;
+                }
+
+            // Graph without index: visited nodes by id, as the library does
+            std::set<graph::_t_node_id> visited;
+            visited.insert(node);
+            graph::_t_node_id current_node = node;
+            do {
+                scratch.edges.clear();
+                scratch.feasible.clear();
+                get_feasible_edges(graph, current_node, scratch.edges, visited);
+                for (auto it = scratch.edges.begin(); it != scratch.edges.end(); ++it) {
+                    if (!edge_removed(**it)) {
+                        scratch.feasible.push_back(*it);
+                        }
+                    }
+                if (scratch.feasible.empty()) {
+                    break;
+                    }
+                rng.at(std::uint32_t(step));
+                const edge_ptr edge = scratch.feasible[rng.below(std::uint32_t(scratch.feasible.size()))];
+                _path.push_back(edge);
+                current_node = edge->end;
+                visited.insert(current_node);
+                succeeded = suc(edge);
+                ++step;
+                }
+            while (!succeeded && step<max_steps);
+            return succeeded;
+            }
+
+        }
+    }
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include "jgsogo/AnCO/algorithm/aco_random.h"
+#include "jgsogo/AnCO/colony/success.h"
+#include "jgsogo/AnCO/graph/graph.h"
+#include "counter_rng.h"
+
+namespace AnCO {
+
+    namespace algorithm {
+
+        /*
+        'aco_random' whose ants walk here instead of inside the library: the
+        walk of 'aco_base::run' (as 'aco_multiobjetivo::run') and the rule of
+        'aco_random' (uniform among the feasible edges), but the ant draws
+        from its own stream ('random_streams::ant'): the edge taken at step
+        's' by the n-th ant of colony 'c' is a pure function of (seed, c, n, s)
+        and of the graph. Its colonies take no lock, run as tasks of their own
+        ('parallel_run') and walk the same paths with any number of threads.
+
+        With the 'graph_index' of the graph installed in the thread
+        ('graph_index::scope'), nodes are visited by index, removed edges
+        are skipped and the edges inserted into the index ('graph_updates')
+        are walked too; on any other graph (the levels of 'search_hierarchy')
+        it walks the edges of the library and skips the removed ones.
+        */
+        class aco_random_streams : public aco_random {
+            public:
+                static bool run(graph& graph, const graph::_t_node_id& node, const unsigned int& pherom_id,
+                                _f_success& suc, std::vector<edge_ptr>& _path, const int& max_steps = 100);
+            };
+
+        }
+
+    template <>
+    struct draws_from_streams<algorithm::aco_random_streams> {
+        static const bool value = true;
+        };
+
+    }
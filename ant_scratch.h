@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <set>
+#include <algorithm>
+
+#include "jgsogo/AnCO/graph/graph.h"
+#include "jgsogo/AnCO/algorithm/aco_base.h"
+#include "objective_set.h"
+#include "graph_index.h"
+#include "graph_updates.h"
+
+namespace AnCO {
+
+    namespace algorithm {
+
+        /*
+        Working memory of an ant, reused by every ant that runs on the same
+        thread ('ant_scratch::local()'). Once the buffers have grown, a walk
+        does no allocation:
+            - nodes are numbered by the 'graph_index' of the graph ('bind'), the
+              thread keeps no map of its own,
+            - 'visited' is an array of epoch stamps indexed by that number
+              (a new ant just bumps the epoch),
+            - 'edges'/'feasible' keep their capacity between steps,
+            - the objectives still pending are a prefix of the 'objective_set'
+              (highest priority first): pruning moves 'n_objetivos' back,
+            - 'objective_node' is the node of every objective (built once per
+              objective set), so goal checks compare integers, not node ids,
+            - 'feasible_index' is the node index of the end of every feasible edge,
+              taken from the address of the edge ('end'), not from its id,
+            - 'collect_feasible' fills both: the out edges of the library and
+              the ones inserted into the index, without the removed ones,
+            - 'selected_paths' is where 'select_paths' moves the surviving paths
+              (swapped with the colony's list, so both keep their capacity).
+        */
+        class ant_scratch {
+            public:
+                typedef graph_index::_t_index _t_index;
+                typedef edge_ptr::element_type _t_edge;
+
+                ant_scratch() : n_objetivos(0), objectives(nullptr), indexed(nullptr), epoch(0), loaded(0) {};
+
+                static ant_scratch& local() {
+                    static thread_local ant_scratch scratch;
+                    return scratch;
+                    };
+
+                // Numbering of the graph the ants of this thread walk now.
+                void bind(const graph_index& index) {
+                    if (&index != indexed || stamps.size() != index.n_nodes()) {
+                        indexed = &index;
+                        stamps.assign(index.n_nodes(), 0);
+                        epoch = 0;
+                        loaded = 0;
+                        }
+                    };
+                _t_index index(const graph::_t_node_id& id) const { return indexed->node(id); };
+                // Index of the end node of 'e': edge address -> end table of the index (the id is only looked up
+                //  for an edge the index doesn't know).
+                _t_index end(const edge_ptr& e) const {
+                    const _t_index i = indexed->end(e.get());
+                    return (i == graph_index::npos) ? this->index(e->end) : i;
+                    };
+
+                void new_ant() {
+                    if (++epoch == 0) {
+                        std::fill(stamps.begin(), stamps.end(), 0);
+                        epoch = 1;
+                        }
+                    };
+                bool visited(_t_index i) const { return stamps[i] == epoch; };
+                void visit(_t_index i) { stamps[i] = epoch; };
+
+                // Edges out of 'node' (index 'current') to nodes this ant has not visited: 'feasible' and 'feasible_index'.
+                void collect_feasible(graph& graph, const graph::_t_node_id& node, _t_index current) {
+                    edges.clear();
+                    feasible.clear();
+                    feasible_index.clear();
+                    aco_base::get_feasible_edges(graph, node, edges, none);
+                    for (auto it = edges.begin(); it != edges.end(); ++it) {
+                        const _t_index i = this->end(*it);
+                        if (!this->visited(i) && !edge_removed(**it)) {
+                            feasible.push_back(*it);
+                            feasible_index.push_back(i);
+                            }
+                        }
+                    // ... and the ones inserted into the live graph ('graph_updates'), unknown to the library
+                    const std::vector<_t_index>& inserted = indexed->inserted_out(current);
+                    for (auto it = inserted.begin(); it != inserted.end(); ++it) {
+                        const _t_index i = indexed->edge_end(*it);
+                        const edge_ptr& e = indexed->get_edges()[*it];
+                        if (!this->visited(i) && !edge_removed(*e)) {
+                            feasible.push_back(e);
+                            feasible_index.push_back(i);
+                            }
+                        }
+                    };
+
+                void load_objectives(const objective_set& set) {
+                    if (set.get_id() != loaded) {
+                        objective_node.clear();
+                        // A node shared by two objectives belongs to the most prioritary one
+                        for (std::size_t oo = 0; oo<set.size(); ++oo) {
+                            _t_index i = this->index(set[oo].node);
+                            if (std::find(objective_node.begin(), objective_node.end(), i) != objective_node.end()) {
+                                i = graph_index::npos;
+                                }
+                            objective_node.push_back(i);
+                            }
+                        loaded = set.get_id();
+                        }
+                    objectives = &set;
+                    n_objetivos = set.size();
+                    };
+                // The node with index 'i' is the base of objective 'oo'
+                bool reached(std::size_t oo, _t_index i) const { return oo < objective_node.size() && objective_node[oo] == i; };
+
+                const std::set<graph::_t_node_id> none;        // 'get_feasible_edges' filter: we keep our own 'visited'
+                std::vector<edge_ptr> edges;                    // out edges of the current node
+                std::vector<edge_ptr> feasible;                 // ... not visited
+                std::vector<_t_index> feasible_index;           // ... dense index of their end node
+                std::size_t n_objetivos;                        // pending objectives: '(*objectives)[0, n_objetivos)'
+                const objective_set* objectives;
+                std::vector<float> pheromone;                   // objetivos x edges (SoA), rows filled on demand
+                std::vector<const _t_edge*> candidates;            // edges scored by 'select_paths'
+                std::vector<std::pair<std::size_t, std::size_t>> owners; // ... (path, position) of each one
+                std::vector<std::pair<std::vector<edge_ptr>, bool>> selected_paths;
+
+            protected:
+                const graph_index* indexed;
+                std::vector<std::uint32_t> stamps;              // one per node of the graph
+                std::uint32_t epoch;
+                std::vector<_t_index> objective_node;           // node of every objective of the loaded set
+                std::uint64_t loaded;                           // id of the objective set in 'objective_node'
+            };
+
+        }
+    }
@@ -0,0 +1,307 @@
+/**
+ * Micro- and macro-benchmarks over synthetic graphs, results as JSON
+ *
+ * @file benchmark.cpp
+ * @section LICENSE
+
+    This code is under MIT License, http://opensource.org/licenses/MIT
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <set>
+#include <algorithm>
+#include <random>
+#include <limits>
+
+#include "jgsogo/AnCO/config.h"
+#include "jgsogo/AnCO/graph/memgraph.h"
+#include "jgsogo/AnCO/graph/graph_data_file.h"
+
+#include "success_meta.h"
+#include "aco_multiobjetivo.h"
+#include "search_pipeline.h"
+#include "graph_generators.h"
+#include "graph_snapshot.h"
+#include "graph_index.h"
+#include "pheromone_scan.h"
+
+using namespace AnCO;
+
+typedef std::chrono::steady_clock bench_clock;
+
+double seconds_since(const bench_clock::time_point& t0) {
+    return std::chrono::duration<double>(bench_clock::now() - t0).count();
+    }
+
+// One JSON object per measure: {"benchmark", "graph", "edges", "nodes", "value", "unit"}
+class json_results {
+    public:
+        json_results(std::ostream& os) : os(os), first(true) {
+            os << "{\"results\": [" << std::endl;
+            };
+        ~json_results() {
+            os << std::endl << "]}" << std::endl;
+            };
+        void add(const std::string& benchmark, const std::string& graph, std::size_t edges, std::size_t nodes, double value, const std::string& unit) {
+            os << (first ? "" : ",\n") << "  {\"benchmark\": \"" << benchmark << "\", \"graph\": \"" << graph
+               << "\", \"edges\": " << edges << ", \"nodes\": " << nodes
+               << ", \"value\": " << value << ", \"unit\": \"" << unit << "\"}";
+            os.flush();
+            first = false;
+            std::clog << "  " << benchmark << " [" << graph << ", " << edges << " edges]: " << value << " " << unit << std::endl;
+            };
+    protected:
+        std::ostream& os;
+        bool first;
+    };
+
+std::string random_node(std::size_t n_nodes, generators::_t_rng& rng) {
+    return std::to_string(std::uniform_int_distribution<std::size_t>(0, n_nodes-1)(rng));
+    }
+
+// aco_multiobjetivo::run: ant-steps per second
+double bench_ant_steps(graph& graph, const graph_index& index, std::size_t n_nodes, generators::_t_rng& rng, unsigned int n_ants, unsigned int max_steps) {
+    std::vector<algorithm::objective_set::objective> objectives;
+    for (unsigned int i = 0; i<4; ++i) {
+        objectives.push_back(algorithm::objective_set::objective(random_node(n_nodes, rng), i, float(i+1)/4.f));
+        }
+    algorithm::aco_multiobjetivo::objective_scope scope(algorithm::objective_set::make(objectives));
+    graph_index::scope index_scope(&index);
+    const unsigned int pherom_id = N_MAX_COLONIES-1;
+
+    std::vector<std::string> starts;
+    for (unsigned int i = 0; i<n_ants; ++i) {
+        starts.push_back(random_node(n_nodes, rng));
+        }
+    success_node_found suc(random_node(n_nodes, rng));
+    std::vector<edge_ptr> path;
+    std::size_t steps = 0;
+    bench_clock::time_point t0 = bench_clock::now();
+    for (auto it = starts.begin(); it != starts.end(); ++it) {
+        path.clear();
+        suc.new_ant();
+        algorithm::aco_multiobjetivo::run(graph, *it, pherom_id, suc, path, max_steps);
+        steps += path.size();
+        }
+    return steps / seconds_since(t0);
+    }
+
+// Multi-objective edge selection split in its two halves, in ns per (edge x objective):
+//  the gather of 'edge->data.pheromone[id]' into the (objectives x edges) matrix and
+//  'pheromone_row_argmax' over it. Nothing is above the threshold, so every row is scanned
+//  (the worst case of 'pick_edge').
+void bench_pheromone_pick(graph& graph, std::size_t n_nodes, generators::_t_rng& rng, std::size_t n_objectives, double& gather, double& scan) {
+    const std::set<graph::_t_node_id> none;
+    std::vector<edge_ptr> out;
+    std::vector<const edge_ptr::element_type*> edges;
+    for (unsigned int i = 0; i<256; ++i) {
+        out.clear();
+        algorithm::aco_base::get_feasible_edges(graph, random_node(n_nodes, rng), out, none);
+        for (auto it = out.begin(); it != out.end(); ++it) {
+            edges.push_back(it->get());
+            }
+        }
+    std::vector<unsigned int> ids;
+    for (std::size_t oo = 0; oo<n_objectives; ++oo) {
+        ids.push_back(unsigned(oo % N_MAX_COLONIES));
+        }
+    const std::size_t n = edges.size(), rounds = 64;
+    std::vector<float> matrix(n_objectives*n);
+    gather = scan = 0.;
+    if (!n) {
+        return;
+        }
+    std::size_t found = 0;
+    for (std::size_t r = 0; r<rounds; ++r) {
+        bench_clock::time_point t0 = bench_clock::now();
+        for (std::size_t oo = 0; oo<n_objectives; ++oo) {
+            float* row = matrix.data() + oo*n;
+            for (std::size_t e = 0; e<n; ++e) {
+                row[e] = edges[e]->data.pheromone[ids[oo]];
+                }
+            }
+        gather += seconds_since(t0);
+        t0 = bench_clock::now();
+        for (std::size_t oo = 0; oo<n_objectives; ++oo) {
+            float value;
+            found += algorithm::pheromone_row_argmax(matrix.data() + oo*n, n, (std::numeric_limits<float>::max)(), value);
+            }
+        scan += seconds_since(t0);
+        }
+    volatile std::size_t sink = found; // keeps the scans
+    (void)sink;
+    const double cells = double(rounds*n_objectives*n);
+    gather *= 1e9/cells;
+    scan *= 1e9/cells;
+    }
+
+// success_meta: paths per second through fingerprinting, dedup and top-K
+double bench_dedup(graph& graph, std::size_t n_nodes, generators::_t_rng& rng, unsigned int n_paths) {
+    // Random walks over the graph (some of them repeated)
+    const std::set<graph::_t_node_id> none;
+    std::vector<std::vector<edge_ptr>> walks;
+    std::vector<edge_ptr> out;
+    for (unsigned int w = 0; w<512; ++w) {
+        std::vector<edge_ptr> walk;
+        std::string node = random_node(n_nodes, rng);
+        for (unsigned int step = 0; step<20; ++step) {
+            out.clear();
+            if (!algorithm::aco_base::get_feasible_edges(graph, node, out, none)) break;
+            walk.push_back(out[std::uniform_int_distribution<std::size_t>(0, out.size()-1)(rng)]);
+            node = walk.back()->end;
+            }
+        if (!walk.empty()) walks.push_back(walk);
+        }
+    if (walks.empty()) {
+        return 0.;
+        }
+    std::vector<std::size_t> order;
+    for (unsigned int i = 0; i<n_paths; ++i) {
+        order.push_back(std::uniform_int_distribution<std::size_t>(0, walks.size()-1)(rng));
+        }
+
+    success_meta success("");
+    bench_clock::time_point t0 = bench_clock::now();
+    for (auto it = order.begin(); it != order.end(); ++it) {
+        const std::vector<edge_ptr>& walk = walks[*it];
+        success.new_ant();
+        for (auto e = walk.begin(); e != walk.end(); ++e) {
+            success(*e);
+            }
+        success.add_to_succesful(success.tmp, success.tmp_fingerprint, success.tmp_cost);
+        }
+    return order.size() / seconds_since(t0);
+    }
+
+int main(int argc, char* argv[]) {
+    std::string config_file, out_file = "benchmark.json";
+    std::vector<std::size_t> sizes = {1000, 10000, 100000};
+    std::vector<std::string> kinds = {"grid", "erdos_renyi", "scale_free"};
+    bool refine = false;
+    std::size_t portfolio = 1;
+    float portfolio_bound = (std::numeric_limits<float>::max)();
+    unsigned int seed = 42, n_ants = 2000, n_paths = 100000, iterations = 10, n_queries = 3, threads = std::thread::hardware_concurrency();
+    for (int i = 1; i<argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = (i+1 < argc);
+        if (arg == "--sizes" && has_value) {
+            sizes.clear();
+            std::istringstream is(argv[++i]);
+            std::string item;
+            while (std::getline(is, item, ',')) sizes.push_back(std::size_t(std::atof(item.c_str())));
+            }
+        else if (arg == "--graphs" && has_value) {
+            kinds.clear();
+            std::istringstream is(argv[++i]);
+            std::string item;
+            while (std::getline(is, item, ',')) kinds.push_back(item);
+            }
+        else if (arg == "--out" && has_value) out_file = argv[++i];
+        else if (arg == "--seed" && has_value) seed = std::atoi(argv[++i]);
+        else if (arg == "--ants" && has_value) n_ants = std::atoi(argv[++i]);
+        else if (arg == "--paths" && has_value) n_paths = std::atoi(argv[++i]);
+        else if (arg == "--iterations" && has_value) iterations = std::atoi(argv[++i]);
+        else if (arg == "--queries" && has_value) n_queries = std::atoi(argv[++i]);
+        else if (arg == "--threads" && has_value) threads = std::atoi(argv[++i]);
+        else if (arg == "--refine") refine = true;
+        else if (arg == "--portfolio" && has_value) portfolio = std::size_t((std::max)(1, std::atoi(argv[++i])));
+        else if (arg == "--portfolio-bound" && has_value) portfolio_bound = float(std::atof(argv[++i]));
+        else if (config_file.empty()) config_file = arg;
+        }
+    if (config_file.empty()) {
+        std::cerr << "Usage: " << argv[0] << " 'CONFIG_FILE' [--sizes 1e3,1e4,...] [--graphs grid,erdos_renyi,scale_free]"
+                  << " [--out FILE (benchmark.json)] [--seed N] [--ants N] [--paths N] [--iterations N] [--queries N] [--threads N] [--refine] [--portfolio N [--portfolio-bound C]]" << std::endl;
+        return 1;
+        }
+    config cfg = load_config(config_file);
+    cfg.training_iterations = iterations;
+
+    std::ofstream os(out_file.c_str());
+    if (!os) {
+        std::cerr << "Cannot write '" << out_file << "'" << std::endl;
+        return 1;
+        }
+    work_stealing_pool pool(threads);
+    generators::_t_rng rng(seed);
+    random_streams::seed(seed);
+    algorithm::aco_multiobjetivo::set_trace(nullptr);
+
+    json_results results(os);
+    // Colonies are built per graph: one whose id has no pheromone slot stops the run
+    try {
+        for (auto kind = kinds.begin(); kind != kinds.end(); ++kind) {
+            for (auto size = sizes.begin(); size != sizes.end(); ++size) {
+                // Graph (through a snapshot, as main.cpp loads it)
+                bench_clock::time_point t0 = bench_clock::now();
+                graph_snapshot_writer dataset;
+                std::size_t n_nodes = 0;
+                if (*kind == "grid") n_nodes = generators::grid(dataset, *size, rng);
+                else if (*kind == "erdos_renyi") n_nodes = generators::erdos_renyi(dataset, *size, rng);
+                else if (*kind == "scale_free") n_nodes = generators::scale_free(dataset, *size, rng);
+                else {
+                    std::cerr << "Unknown graph '" << *kind << "'" << std::endl;
+                    return 1;
+                    }
+                const std::string snapshot_file = out_file + ".snapshot";
+                graph_snapshot snapshot;
+                dataset.write(snapshot_file);
+                snapshot.open(snapshot_file);
+                std::unique_ptr<memgraph> graph_ptr = snapshot.make_graph();
+                memgraph& graph = *graph_ptr;
+                graph_index index(snapshot, graph);
+                results.add("graph_build", *kind, *size, n_nodes, seconds_since(t0), "s");
+
+                // Micro
+                results.add("ant_steps", *kind, *size, n_nodes, bench_ant_steps(graph, index, n_nodes, rng, n_ants, cfg.max_steps), "steps/s");
+                for (std::size_t n_objectives = 1; n_objectives<=64; n_objectives *= 8) {
+                    double gather, scan;
+                    bench_pheromone_pick(graph, n_nodes, rng, n_objectives, gather, scan);
+                    const std::string suffix = "_" + std::to_string(n_objectives) + "_objectives";
+                    results.add("pheromone_gather" + suffix, *kind, *size, n_nodes, gather, "ns/cell");
+                    results.add("pheromone_argmax" + suffix, *kind, *size, n_nodes, scan, "ns/cell");
+                    }
+                results.add("success_meta_dedup", *kind, *size, n_nodes, bench_dedup(graph, n_nodes, rng, n_paths), "paths/s");
+
+                // Macro: neighbourhood iterations (run + update + update_graph)
+                search_pipeline pipeline(graph, index, cfg, pool);
+                t0 = bench_clock::now();
+                for (unsigned int i = 0; i<iterations; ++i) {
+                    pipeline.iterate();
+                    }
+                results.add("neighbourhood_iteration", *kind, *size, n_nodes, seconds_since(t0)/(std::max)(1u, iterations), "s");
+
+                // Macro: end-to-end query latency (steps 5-8 of main.cpp)
+                double total = 0.;
+                for (unsigned int q = 0; q<n_queries; ++q) {
+                    t0 = bench_clock::now();
+                    search_query query(pipeline, random_node(n_nodes, rng), random_node(n_nodes, rng));
+                    std::vector<edge_ptr> metapath, path;
+                    query.answer(metapath, path, refine, portfolio, portfolio_bound);
+                    total += seconds_since(t0);
+                    }
+                if (n_queries) {
+                    std::string name = refine ? "query_latency_refined" : "query_latency";
+                    if (portfolio > 1) {
+                        name += "_portfolio";
+                        }
+                    results.add(name, *kind, *size, n_nodes, total/n_queries, "s");
+                    }
+                }
+            }
+        }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        std::remove((out_file + ".snapshot").c_str());
+        return 1;
+        }
+    std::remove((out_file + ".snapshot").c_str());
+    return 0;
+    }
@@ -0,0 +1,359 @@
+
+#include "checkpoint.h"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+#include <set>
+#include <algorithm>
+
+#ifdef _WINDOWS
+    #include <windows.h>
+#endif
+
+#include "jgsogo/AnCO/algorithm/aco_base.h"
+#include "hierarchy.h"
+
+namespace AnCO {
+
+    namespace {
+        const char checkpoint_magic[8] = {'A', 'n', 'C', 'O', 'C', 'K', 'P', 'T'};
+        enum frame_type { frame_full = 1, frame_delta = 2 };
+
+        struct file_header {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t n_max_colonies;
+            std::uint64_t n_edges;
+            std::uint64_t fingerprint;
+            };
+
+        struct frame_header {
+            std::uint32_t type;
+            std::uint32_t iteration;
+            std::uint64_t n_colonies;
+            std::uint64_t n_records;
+            std::uint64_t bytes;  // size of the frame after this header
+            };
+
+        std::uint64_t fnv1a(std::uint64_t h, const void* data, std::size_t size) {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            for (std::size_t i = 0; i<size; ++i) {
+                h = (h ^ p[i]) * 1099511628211ULL;
+                }
+            return h;
+            }
+
+        // Atomic rename over an existing file (std::rename fails on Windows if 'to' exists)
+        bool replace_file(const std::string& from, const std::string& to) {
+            #ifdef _WINDOWS
+                return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+            #else
+                return std::rename(from.c_str(), to.c_str()) == 0;
+            #endif
+            }
+
+        template <typename T>
+        void write_pod(std::ostream& os, const T& value) {
+            os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+            }
+
+        template <typename T>
+        bool read_pod(std::istream& is, T& value) {
+            return bool(is.read(reinterpret_cast<char*>(&value), sizeof(T)));
+            }
+
+        // Base nodes, then for each colony its neighbours as '(count, [col, value]...)'
+        std::uint64_t colonies_bytes(const std::vector<graph::_t_node_id>& base_nodes, const sparse_proximity& proximity) {
+            std::uint64_t bytes = 0;
+            for (auto it = base_nodes.begin(); it != base_nodes.end(); ++it) {
+                bytes += sizeof(std::uint32_t) + it->size();
+                }
+            bytes += proximity.n_rows()*sizeof(std::uint32_t) + proximity.n_entries()*sizeof(sparse_proximity::entry);
+            return bytes;
+            }
+
+        void write_colonies(std::ostream& os, const std::vector<graph::_t_node_id>& base_nodes, const sparse_proximity& proximity) {
+            for (auto it = base_nodes.begin(); it != base_nodes.end(); ++it) {
+                write_pod(os, std::uint32_t(it->size()));
+                os.write(it->data(), it->size());
+                }
+            for (std::size_t i = 0; i<proximity.n_rows(); ++i) {
+                write_pod(os, std::uint32_t(proximity.end(i) - proximity.begin(i)));
+                os.write(reinterpret_cast<const char*>(proximity.begin(i)), (proximity.end(i) - proximity.begin(i))*sizeof(sparse_proximity::entry));
+                }
+            }
+
+        bool read_colonies(std::istream& is, std::size_t n_colonies, std::vector<graph::_t_node_id>& base_nodes, sparse_proximity& proximity) {
+            base_nodes.resize(n_colonies);
+            for (auto it = base_nodes.begin(); it != base_nodes.end(); ++it) {
+                std::uint32_t size;
+                if (!read_pod(is, size)) return false;
+                it->resize(size);
+                if (size && !is.read(&(*it)[0], size)) return false;
+                }
+            proximity.resize(n_colonies);
+            std::vector<sparse_proximity::entry> row;
+            for (std::size_t i = 0; i<n_colonies; ++i) {
+                std::uint32_t size;
+                if (!read_pod(is, size)) return false;
+                row.resize(size);
+                if (size && !is.read(reinterpret_cast<char*>(row.data()), std::streamsize(size*sizeof(sparse_proximity::entry)))) return false;
+                proximity.set_row(i, row.data(), row.data() + row.size());
+                }
+            return true;
+            }
+        }
+
+    checkpoint::checkpoint(const std::string& filename, const graph_snapshot& snapshot, graph& graph, unsigned int slices)
+        : filename(filename), slices((std::max)(1u, slices)), captured_edges(0), full_bytes(0), delta_bytes(0), writing(false) {
+        // Edges in snapshot order
+        const std::set<graph::_t_node_id> none;
+        std::vector<edge_ptr> out;
+        fingerprint = 14695981039346656037ULL;
+        for (std::size_t i = 0; i<snapshot.n_nodes(); ++i) {
+            out.clear();
+            algorithm::aco_base::get_feasible_edges(graph, snapshot.node_id(graph_snapshot::_t_index(i)), out, none);
+            for (auto it = out.begin(); it != out.end(); ++it) {
+                fingerprint = fnv1a(fingerprint, (*it)->init.data(), (*it)->init.size());
+                fingerprint = fnv1a(fingerprint, (*it)->end.data(), (*it)->end.size());
+                edges.push_back(*it);
+                }
+            }
+        }
+
+    checkpoint::~checkpoint() {
+        this->wait();
+        }
+
+    void checkpoint::wait() {
+        if (writer.joinable()) {
+            writer.join();
+            }
+        }
+
+    bool checkpoint::save(search_pipeline& pipeline) {
+        if (!capture) {
+            if (writing) {
+                return false;
+                }
+            this->wait();
+            capture.reset(new state());
+            capture->iteration = pipeline.get_iteration();
+            auto colonies = pipeline.get_neighbourhood().get_colonies();
+            for (auto it = colonies.begin(); it != colonies.end(); ++it) {
+                capture->base_nodes.push_back((*it)->get_base_node());
+                }
+            capture->proximity = pipeline.get_meta_graph().get_proximity();
+            capture->pheromone.resize(edges.size());
+            captured_edges = 0;
+            }
+
+        // Next slice (pending lazy evaporation first)
+        lazy_evaporation* evaporation = pipeline.get_lazy_evaporation();
+        const std::size_t end = (std::min)(edges.size(), captured_edges + (edges.size() + slices - 1)/slices);
+        for (std::size_t e = captured_edges; e<end; ++e) {
+            if (evaporation) {
+                evaporation->touch(edges[e].get());
+                }
+            capture->pheromone.set(e, edges[e]->data.pheromone);
+            }
+        captured_edges = end;
+        if (captured_edges < edges.size()) {
+            return true;
+            }
+
+        writing = true;
+        writer = std::thread(&checkpoint::write, this, capture.release());
+        return true;
+        }
+
+    void checkpoint::write(state* captured) {
+        std::unique_ptr<state> s(captured);
+        const std::size_t n = N_MAX_COLONIES;
+        try {
+            frame_header frame;
+            frame.iteration = s->iteration;
+            frame.n_colonies = s->base_nodes.size();
+
+            if (written.n_edges() != s->pheromone.n_edges() || delta_bytes > full_bytes) {
+                // Full rewrite
+                frame.type = frame_full;
+                frame.n_records = edges.size();
+                frame.bytes = colonies_bytes(s->base_nodes, s->proximity);
+                for (std::size_t e = 0; e<edges.size(); ++e) {
+                    frame.bytes += s->pheromone.record_bytes(e);
+                    }
+
+                std::string tmp = filename + ".tmp";
+                {
+                    std::ofstream os(tmp.c_str(), std::ios::binary | std::ios::trunc);
+                    file_header header;
+                    std::memcpy(header.magic, checkpoint_magic, sizeof(checkpoint_magic));
+                    header.version = checkpoint::version;
+                    header.n_max_colonies = std::uint32_t(n);
+                    header.n_edges = edges.size();
+                    header.fingerprint = fingerprint;
+                    write_pod(os, header);
+                    write_pod(os, frame);
+                    write_colonies(os, s->base_nodes, s->proximity);
+                    for (std::size_t e = 0; e<edges.size(); ++e) {
+                        s->pheromone.write(os, e);
+                        }
+                    if (!os) {
+                        throw std::runtime_error("cannot write '" + tmp + "'");
+                        }
+                }
+                if (!replace_file(tmp, filename)) {
+                    throw std::runtime_error("cannot rename '" + tmp + "'");
+                    }
+                full_bytes = sizeof(frame_header) + frame.bytes;
+                delta_bytes = 0;
+                std::swap(written, s->pheromone);
+                }
+            else {
+                // Only the edges that changed since the previous frame
+                std::vector<std::uint32_t> changed;
+                frame.bytes = colonies_bytes(s->base_nodes, s->proximity);
+                for (std::size_t e = 0; e<edges.size(); ++e) {
+                    if (!s->pheromone.same(e, written, e)) {
+                        changed.push_back(std::uint32_t(e));
+                        frame.bytes += sizeof(std::uint32_t) + s->pheromone.record_bytes(e);
+                        }
+                    }
+                frame.type = frame_delta;
+                frame.n_records = changed.size();
+
+                std::ofstream os(filename.c_str(), std::ios::binary | std::ios::app);
+                write_pod(os, frame);
+                write_colonies(os, s->base_nodes, s->proximity);
+                for (auto it = changed.begin(); it != changed.end(); ++it) {
+                    write_pod(os, *it);
+                    s->pheromone.write(os, *it);
+                    written.copy(*it, s->pheromone, *it);
+                    }
+                if (!os) {
+                    throw std::runtime_error("cannot append to '" + filename + "'");
+                    }
+                delta_bytes += sizeof(frame_header) + frame.bytes;
+                }
+            }
+        catch (std::exception& e) {
+            std::cerr << "checkpoint: " << e.what() << std::endl;
+            written.resize(0); // next one will be a full rewrite
+            }
+        writing = false;
+        }
+
+    bool checkpoint::load(search_pipeline& pipeline) {
+        std::ifstream is(filename.c_str(), std::ios::binary);
+        file_header header;
+        if (!is || !read_pod(is, header) || std::memcmp(header.magic, checkpoint_magic, sizeof(checkpoint_magic)) != 0) {
+            return false;
+            }
+        const std::size_t n = N_MAX_COLONIES;
+        if (header.version != checkpoint::version || header.n_max_colonies != n || header.n_edges != edges.size() || header.fingerprint != fingerprint) {
+            std::cerr << "checkpoint: '" << filename << "' was written for a different graph or build" << std::endl;
+            return false;
+            }
+
+        state s;
+        bool has_full = false, truncated = false;
+        std::uint64_t bytes_full = 0, bytes_delta = 0;
+        frame_header frame;
+        while (!truncated && read_pod(is, frame)) {
+            truncated = true;
+            std::streampos begin = is.tellg();
+            std::vector<graph::_t_node_id> base_nodes;
+            sparse_proximity prox(pipeline.get_meta_graph().max_neighbours());
+            if (!read_colonies(is, std::size_t(frame.n_colonies), base_nodes, prox)) {
+                break; // truncated frame: keep the previous state
+                }
+            if (frame.type == frame_full) {
+                checkpoint_pheromone pheromone;
+                pheromone.resize(edges.size());
+                bool complete = true;
+                for (std::size_t e = 0; e<edges.size() && complete; ++e) {
+                    complete = pheromone.read(is, e);
+                    }
+                if (!complete) {
+                    break;
+                    }
+                std::swap(s.pheromone, pheromone);
+                has_full = true;
+                bytes_full = sizeof(frame_header) + frame.bytes;
+                bytes_delta = 0;
+                }
+            else if (frame.type == frame_delta && has_full) {
+                // Applied only once the whole frame has been read
+                checkpoint_pheromone records;
+                records.resize(std::size_t((std::min)(frame.n_records, std::uint64_t(edges.size()))));
+                std::vector<std::uint32_t> ids;
+                bool complete = (frame.n_records <= edges.size());
+                for (std::uint64_t r = 0; r<frame.n_records && complete; ++r) {
+                    std::uint32_t e;
+                    complete = read_pod(is, e) && (e < edges.size()) && records.read(is, std::size_t(r));
+                    ids.push_back(e);
+                    }
+                if (!complete) {
+                    break;
+                    }
+                for (std::size_t r = 0; r<ids.size(); ++r) {
+                    s.pheromone.copy(ids[r], records, r);
+                    }
+                bytes_delta += sizeof(frame_header) + frame.bytes;
+                }
+            else {
+                break;
+                }
+            if (std::uint64_t(is.tellg() - begin) != frame.bytes) {
+                break;
+                }
+            s.iteration = frame.iteration;
+            s.base_nodes.swap(base_nodes);
+            s.proximity = prox;
+            truncated = false;
+            }
+        if (!has_full) {
+            return false;
+            }
+
+        auto colonies = pipeline.get_neighbourhood().get_colonies();
+        if (colonies.size() != s.base_nodes.size()) {
+            std::cerr << "checkpoint: '" << filename << "' has " << s.base_nodes.size() << " colonies, expected " << colonies.size() << std::endl;
+            return false;
+            }
+
+        std::lock_guard<std::mutex> lock(pipeline.get_mutex());
+        for (std::size_t i = 0; i<colonies.size(); ++i) {
+            colonies[i]->set_base_node(s.base_nodes[i]);
+            }
+        for (std::size_t e = 0; e<edges.size(); ++e) {
+            s.pheromone.get(e, edges[e]->data.pheromone);
+            }
+        if (lazy_evaporation* evaporation = pipeline.get_lazy_evaporation()) {
+            evaporation->reset();
+            }
+        pipeline.set_iteration(s.iteration);
+        pipeline.get_meta_graph().restore(s.base_nodes, s.proximity);
+        if (search_hierarchy* hierarchy = pipeline.get_hierarchy()) {
+            hierarchy->invalidate();
+            }
+        proximity = s.proximity;
+
+        // Following saves are appended to this file
+        this->wait();
+        capture.reset();
+        std::swap(written, s.pheromone);
+        if (truncated) {
+            written.resize(0); // do not append after a damaged frame
+            }
+        full_bytes = bytes_full;
+        delta_bytes = bytes_delta;
+        return true;
+        }
+
+    }
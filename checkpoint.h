@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+
+#include "jgsogo/AnCO/graph/graph.h"
+#include "graph_snapshot.h"
+#include "search_pipeline.h"
+#include "sparse_proximity.h"
+#include "checkpoint_pheromone.h"
+
+namespace AnCO {
+
+    /*
+    Versioned binary checkpoint of the learned state: the pheromone of every
+    edge of the graph, the base node of every colony of the neighbourhood and
+    its proximity (the sparse top-k kept by the meta-graph maintainer).
+
+    The file is a log of frames: a FULL frame with every edge followed by
+    DELTA frames with only the edges whose pheromone changed since the
+    previous frame. The pheromone has to be read while the caller holds the
+    pipeline mutex, so 'save' captures it in 'slices' parts, one per call
+    (one per training iteration): no iteration pays for more than
+    'n_edges/slices' edges. The capture is fuzzy (each slice is the one of
+    the iteration it was taken at) and is diffed and written in a background
+    thread once complete; if the previous write has not finished yet the
+    request is skipped, so training never waits for the disk. When the
+    deltas grow larger than a full frame the file is rewritten (temporary
+    file + rename over the old one). Pheromone is kept (in memory and on
+    disk) as a 'checkpoint_pheromone': only the slots of each edge that differ
+    from its most common value.
+
+    Edges are enumerated in snapshot order, so a checkpoint only restores
+    into a graph loaded from the same snapshot (checked with a fingerprint).
+    */
+    class checkpoint {
+        public:
+            static const std::uint32_t version = 3;
+
+            checkpoint(const std::string& filename, const graph_snapshot& snapshot, graph& graph, unsigned int slices = 1);
+            ~checkpoint();
+
+            // Starts a capture of the current state or takes its next slice (caller holds the pipeline
+            // mutex); the last slice hands it to the background writer. Returns false if the previous
+            // capture is still being written.
+            bool save(search_pipeline& pipeline);
+            // A capture has been started and needs more calls to 'save'.
+            bool capturing() const { return bool(capture); };
+            void wait();
+
+            // Restores pheromone, colony placement and iteration count. Returns false if there is no
+            // usable checkpoint. The restored proximity seeds the meta-graph of the pipeline, which keeps
+            // it for every colony until the neighbourhood has learned some of its own (see
+            // 'meta_graph_maintainer::restore'), and is also available through 'get_proximity'.
+            bool load(search_pipeline& pipeline);
+            const sparse_proximity& get_proximity() const { return proximity; };
+
+        protected:
+            struct state {
+                std::uint32_t iteration;
+                std::vector<graph::_t_node_id> base_nodes;
+                sparse_proximity proximity;
+                checkpoint_pheromone pheromone;
+                };
+
+            void write(state* captured);
+
+            std::string filename;
+            std::vector<edge_ptr> edges;
+            std::uint64_t fingerprint;
+            unsigned int slices;
+
+            std::unique_ptr<state> capture;     // being captured
+            std::size_t captured_edges;
+
+            checkpoint_pheromone written;       // pheromone as stored in the file
+            std::uint64_t full_bytes, delta_bytes;
+            std::thread writer;
+            std::atomic<bool> writing;
+
+            sparse_proximity proximity;
+        };
+
+    }
@@ -0,0 +1,189 @@
+
+#include "checkpoint_pheromone.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace AnCO {
+
+    namespace {
+        // Bitwise comparison, so the encoding is exact (-0.f, NaN...)
+        inline bool same_bits(float lhs, float rhs) {
+            return std::memcmp(&lhs, &rhs, sizeof(float)) == 0;
+            }
+
+        inline std::uint32_t bits(float value) {
+            std::uint32_t b;
+            std::memcpy(&b, &value, sizeof(float));
+            return b;
+            }
+        }
+
+    void checkpoint_pheromone::resize(std::size_t n_edges) {
+        record empty;
+        empty.base = 0.f;
+        empty.count = 0;
+        empty.overflow = no_overflow;
+        records.assign(n_edges, empty);
+        overflow.clear();
+        free_overflow.clear();
+        }
+
+    std::size_t checkpoint_pheromone::memory() const {
+        std::size_t bytes = records.capacity()*sizeof(record);
+        for (auto it = overflow.begin(); it != overflow.end(); ++it) {
+            bytes += it->capacity()*sizeof(entry);
+            }
+        return bytes;
+        }
+
+    const checkpoint_pheromone::entry* checkpoint_pheromone::begin(std::size_t e) const {
+        const record& r = records[e];
+        return (r.overflow == no_overflow) ? r.entries : overflow[r.overflow].data();
+        }
+
+    void checkpoint_pheromone::set(std::size_t e, const float* pheromone) {
+        // Most frequent value: a majority vote finds it in one pass when it is more than half
+        //  of the slots (the usual case), otherwise the longest run of the sorted bit patterns.
+        float base = 0.f;
+        std::size_t votes = 0;
+        for (std::size_t i = 0; i<n_slots; ++i) {
+            if (votes == 0) {
+                base = pheromone[i];
+                votes = 1;
+                }
+            else if (same_bits(pheromone[i], base)) {
+                ++votes;
+                }
+            else {
+                --votes;
+                }
+            }
+        std::size_t count = 0;
+        for (std::size_t i = 0; i<n_slots; ++i) {
+            count += same_bits(pheromone[i], base) ? 1 : 0;
+            }
+        if (2*count <= n_slots) {
+            sorted.assign(pheromone, pheromone + n_slots);
+            std::sort(sorted.begin(), sorted.end(), [](float lhs, float rhs){ return bits(lhs) < bits(rhs); });
+            std::size_t best = 0;
+            for (std::size_t i = 0, j = 0; i<sorted.size(); i = j) {
+                for (j = i+1; j<sorted.size() && same_bits(sorted[j], sorted[i]); ++j);
+                if (j - i > best) {
+                    best = j - i;
+                    base = sorted[i];
+                    }
+                }
+            }
+        scratch.clear();
+        for (std::size_t i = 0; i<n_slots; ++i) {
+            if (!same_bits(pheromone[i], base)) {
+                entry en = {std::uint16_t(i), pheromone[i]};
+                scratch.push_back(en);
+                }
+            }
+        this->assign(e, base, scratch.data(), scratch.data() + scratch.size());
+        }
+
+    void checkpoint_pheromone::get(std::size_t e, float* pheromone) const {
+        const record& r = records[e];
+        std::fill(pheromone, pheromone + n_slots, r.base);
+        const entry* it = this->begin(e);
+        for (const entry* end = it + r.count; it != end; ++it) {
+            pheromone[it->slot] = it->value;
+            }
+        }
+
+    float checkpoint_pheromone::get(std::size_t e, std::size_t slot) const {
+        const record& r = records[e];
+        const entry* first = this->begin(e);
+        const entry* it = std::lower_bound(first, first + r.count, slot, [](const entry& en, std::size_t s){ return en.slot < s; });
+        return (it != first + r.count && it->slot == slot) ? it->value : r.base;
+        }
+
+    bool checkpoint_pheromone::same(std::size_t e, const checkpoint_pheromone& other, std::size_t other_e) const {
+        const record& lhs = records[e];
+        const record& rhs = other.records[other_e];
+        if (!same_bits(lhs.base, rhs.base) || lhs.count != rhs.count) {
+            return false;
+            }
+        const entry* a = this->begin(e);
+        const entry* b = other.begin(other_e);
+        for (std::uint32_t i = 0; i<lhs.count; ++i) {
+            if (a[i].slot != b[i].slot || !same_bits(a[i].value, b[i].value)) {
+                return false;
+                }
+            }
+        return true;
+        }
+
+    void checkpoint_pheromone::copy(std::size_t e, const checkpoint_pheromone& other, std::size_t other_e) {
+        const record& r = other.records[other_e];
+        const entry* first = other.begin(other_e);
+        if (&other == this) {
+            scratch.assign(first, first + r.count);
+            first = scratch.data();
+            }
+        this->assign(e, r.base, first, first + r.count);
+        }
+
+    void checkpoint_pheromone::assign(std::size_t e, float base, const entry* first, const entry* last) {
+        record& r = records[e];
+        const std::size_t count = last - first;
+        r.base = base;
+        r.count = std::uint32_t(count);
+        if (count <= inline_capacity) {
+            std::copy(first, last, r.entries);
+            if (r.overflow != no_overflow) {
+                overflow[r.overflow].clear();
+                free_overflow.push_back(r.overflow);
+                r.overflow = no_overflow;
+                }
+            }
+        else {
+            if (r.overflow == no_overflow) {
+                if (free_overflow.empty()) {
+                    r.overflow = std::uint32_t(overflow.size());
+                    overflow.push_back(std::vector<entry>());
+                    }
+                else {
+                    r.overflow = free_overflow.back();
+                    free_overflow.pop_back();
+                    }
+                }
+            overflow[r.overflow].assign(first, last);
+            }
+        }
+
+    std::size_t checkpoint_pheromone::record_bytes(std::size_t e) const {
+        return sizeof(float) + sizeof(std::uint32_t) + records[e].count*(sizeof(std::uint16_t) + sizeof(float));
+        }
+
+    void checkpoint_pheromone::write(std::ostream& os, std::size_t e) const {
+        const record& r = records[e];
+        os.write(reinterpret_cast<const char*>(&r.base), sizeof(float));
+        os.write(reinterpret_cast<const char*>(&r.count), sizeof(std::uint32_t));
+        const entry* it = this->begin(e);
+        for (const entry* end = it + r.count; it != end; ++it) {
+            os.write(reinterpret_cast<const char*>(&it->slot), sizeof(std::uint16_t));
+            os.write(reinterpret_cast<const char*>(&it->value), sizeof(float));
+            }
+        }
+
+    bool checkpoint_pheromone::read(std::istream& is, std::size_t e) {
+        float base;
+        std::uint32_t count;
+        if (!is.read(reinterpret_cast<char*>(&base), sizeof(float)) || !is.read(reinterpret_cast<char*>(&count), sizeof(std::uint32_t)) || count > n_slots) {
+            return false;
+            }
+        scratch.resize(count);
+        for (auto it = scratch.begin(); it != scratch.end(); ++it) {
+            if (!is.read(reinterpret_cast<char*>(&it->slot), sizeof(std::uint16_t)) || !is.read(reinterpret_cast<char*>(&it->value), sizeof(float)) || it->slot >= n_slots) {
+                return false;
+                }
+            }
+        this->assign(e, base, scratch.data(), scratch.data() + scratch.size());
+        return true;
+        }
+
+    }
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <istream>
+#include <ostream>
+
+namespace AnCO {
+
+    /*
+    Pheromone of the edges as kept by a 'checkpoint' (in memory, to diff the
+    captures, and on disk). It is only a compression for checkpoints: the
+    ants keep reading and writing the dense arrays of the library, so the
+    live pheromone of the graph still takes 'n_edges * N_MAX_COLONIES'
+    floats (the array is a member of the edges of the library).
+
+    Most of the 'n_slots' values of an edge are the same (colonies that
+    never walked it), so each edge is stored as the most frequent value
+    plus the slots that differ: up to 'inline_capacity' of them inside the
+    record and the rest in a side table. An edge touched by a few colonies
+    takes 44 bytes (base, count and overflow index, 4 bytes each, and 4
+    inline entries of 8) instead of 'n_slots*4'.
+
+    The encoding is canonical (same dense values, same record: a tie for the
+    most frequent value goes to the lowest bit pattern), so two stores can
+    be compared edge by edge without expanding them.
+    */
+    class checkpoint_pheromone {
+        public:
+            struct entry {
+                std::uint16_t slot;
+                float value;
+                };
+            static const std::size_t inline_capacity = 4;
+
+            explicit checkpoint_pheromone(std::size_t n_slots = N_MAX_COLONIES) : n_slots(n_slots) {};
+
+            void resize(std::size_t n_edges);
+            std::size_t n_edges() const { return records.size(); };
+            std::size_t memory() const;
+
+            // From/to the dense array of an edge ('n_slots' values).
+            void set(std::size_t e, const float* pheromone);
+            void get(std::size_t e, float* pheromone) const;
+            float get(std::size_t e, std::size_t slot) const;
+
+            bool same(std::size_t e, const checkpoint_pheromone& other, std::size_t other_e) const;
+            void copy(std::size_t e, const checkpoint_pheromone& other, std::size_t other_e);
+
+            // Binary record: 'base, count, (slot, value) x count'
+            std::size_t record_bytes(std::size_t e) const;
+            void write(std::ostream& os, std::size_t e) const;
+            bool read(std::istream& is, std::size_t e);
+
+        protected:
+            struct record {
+                float base;
+                std::uint32_t count;
+                std::uint32_t overflow;    // index in 'overflow' when 'count > inline_capacity'
+                entry entries[inline_capacity];
+                };
+            static const std::uint32_t no_overflow = 0xFFFFFFFF;
+
+            const entry* begin(std::size_t e) const;
+            void assign(std::size_t e, float base, const entry* first, const entry* last);
+
+            std::size_t n_slots;
+            std::vector<record> records;
+            std::vector<std::vector<entry>> overflow;
+            std::vector<std::uint32_t> free_overflow;
+            std::vector<entry> scratch;
+            std::vector<float> sorted;
+        };
+
+    }
@@ -0,0 +1,39 @@
+
+#include "convergence_monitor.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace AnCO {
+
+    bool convergence_monitor::add(const std::vector<double>& values) {
+        if (opts.window == 0) {
+            return false;
+            }
+        if (!history.empty() && history.back().size() != values.size()) {
+            history.clear(); // the set of signals changed (new colonies): start over
+            }
+        history.push_back(values);
+        if (history.size() > opts.window) {
+            history.pop_front();
+            }
+        if (history.size() < opts.window) {
+            return done = false;
+            }
+
+        for (std::size_t s = 0; s<values.size(); ++s) {
+            double min = history.front()[s], max = min, sum = 0.;
+            for (auto it = history.begin(); it != history.end(); ++it) {
+                min = (std::min)(min, (*it)[s]);
+                max = (std::max)(max, (*it)[s]);
+                sum += (*it)[s];
+                }
+            const double scale = (std::max)(1., std::fabs(sum/history.size()));
+            if (max - min > opts.tolerance*scale) {
+                return done = false;
+                }
+            }
+        return done = true;
+        }
+
+    }
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+
+namespace AnCO {
+
+    /*
+    Decides when a training phase has stopped improving. Every iteration the
+    phase adds the same set of signals (metric of each colony, edges of the
+    meta-graph that changed, new paths found, best cost...) and the phase is
+    converged once every signal has stayed within 'tolerance' (relative to
+    its magnitude, absolute below 1) for the last 'window' iterations.
+
+    A 'window' of 0 disables it: 'add' never reports convergence and the
+    phase runs up to its iteration cap, as before.
+    */
+    class convergence_monitor {
+        public:
+            struct options {
+                options(std::size_t window = 0, double tolerance = 0.01) : window(window), tolerance(tolerance) {};
+                std::size_t window;
+                double tolerance;
+                };
+
+            convergence_monitor(const options& opts = options()) : opts(opts), done(false) {};
+
+            void reset() { history.clear(); done = false; };
+            const options& get_options() const { return opts; };
+
+            // Values of this iteration; returns true once converged.
+            bool add(const std::vector<double>& values);
+            bool add(double value) { return this->add(std::vector<double>(1, value)); };
+            bool converged() const { return done; };
+
+        protected:
+            options opts;
+            std::deque<std::vector<double>> history;
+            bool done;
+        };
+
+    }
@@ -0,0 +1,248 @@
+
+#include "corridor_path.h"
+
+#include <set>
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+#include "jgsogo/AnCO/algorithm/aco_base.h"
+#include "lazy_evaporation.h"
+#include "graph_updates.h"
+
+namespace AnCO {
+
+    namespace algorithm {
+
+        namespace {
+            // One side of the bidirectional search: tentative distance of every node it has reached and the
+            //  position of the edge it was reached by (out of the node towards 'end' for the backward side)
+            class frontier {
+                public:
+                    typedef graph_index::_t_index _t_index;
+                    static const std::size_t no_edge = std::size_t(-1);
+
+                    float top() const { return queue.empty() ? (std::numeric_limits<float>::infinity)() : queue.top().first; };
+                    const float* distance(_t_index i) const {
+                        auto it = labels.find(i);
+                        return (it == labels.end()) ? nullptr : &it->second.distance;
+                        };
+                    std::size_t edge(_t_index i) const { return labels.find(i)->second.edge; };
+
+                    void push(_t_index i, float d, std::size_t e) {
+                        label empty = {(std::numeric_limits<float>::infinity)(), no_edge, false};
+                        label& l = labels.insert(std::make_pair(i, empty)).first->second;
+                        if (!l.settled && d < l.distance) {
+                            l.distance = d;
+                            l.edge = e;
+                            queue.push(std::make_pair(d, i));
+                            }
+                        };
+                    bool pop(_t_index& i, float& d) {
+                        while (!queue.empty()) {
+                            const _t_item item = queue.top();
+                            queue.pop();
+                            label& l = labels[item.second];
+                            if (l.settled || item.first > l.distance) {
+                                continue;
+                                }
+                            l.settled = true;
+                            i = item.second;
+                            d = item.first;
+                            return true;
+                            }
+                        return false;
+                        };
+
+                protected:
+                    typedef std::pair<float, _t_index> _t_item;
+                    struct label {
+                        float distance;
+                        std::size_t edge;
+                        bool settled;
+                        };
+                    std::unordered_map<_t_index, label> labels;
+                    std::priority_queue<_t_item, std::vector<_t_item>, std::greater<_t_item>> queue;
+                };
+            }
+
+        bool corridor_path(graph& graph, const graph::_t_node_id& start, const graph::_t_node_id& end,
+                           const std::vector<unsigned int>& pherom_ids, float threshold,
+                           std::vector<edge_ptr>& path) {
+            typedef std::uint32_t _t_index;
+            typedef std::pair<float, _t_index> _t_item;
+
+            path.clear();
+            if (start == end) {
+                return true;
+                }
+
+            std::unordered_map<graph::_t_node_id, _t_index> ids;
+            std::vector<const graph::_t_node_id*> nodes;
+            std::vector<float> distance;
+            std::vector<edge_ptr> parent;
+            std::vector<bool> settled;
+            auto index = [&](const graph::_t_node_id& id) {
+                auto it = ids.insert(std::make_pair(id, _t_index(nodes.size())));
+                if (it.second) {
+                    nodes.push_back(&it.first->first);
+                    distance.push_back((std::numeric_limits<float>::max)());
+                    parent.push_back(edge_ptr());
+                    settled.push_back(false);
+                    }
+                return it.first->second;
+                };
+
+            lazy_evaporation* evaporation = lazy_evaporation::current();
+            const std::set<graph::_t_node_id> none;
+            std::vector<edge_ptr> out;
+            std::priority_queue<_t_item, std::vector<_t_item>, std::greater<_t_item>> queue;
+
+            const _t_index source = index(start);
+            distance[source] = 0.f;
+            queue.push(std::make_pair(0.f, source));
+            while (!queue.empty()) {
+                const _t_item item = queue.top();
+                queue.pop();
+                const _t_index u = item.second;
+                if (settled[u]) {
+                    continue;
+                    }
+                settled[u] = true;
+                if (*nodes[u] == end) {
+                    // Walk back the parents
+                    for (_t_index v = u; v != source; v = ids[parent[v]->init]) {
+                        path.push_back(parent[v]);
+                        }
+                    std::reverse(path.begin(), path.end());
+                    return true;
+                    }
+
+                out.clear();
+                aco_base::get_feasible_edges(graph, *nodes[u], out, none);
+                for (auto it = out.begin(); it != out.end(); ++it) {
+                    const edge_ptr& e = *it;
+                    if (edge_removed(*e)) {
+                        continue;
+                        }
+                    if (evaporation) {
+                        evaporation->touch(e.get());
+                        }
+                    bool in_corridor = false;
+                    for (auto id = pherom_ids.begin(); id != pherom_ids.end() && !in_corridor; ++id) {
+                        in_corridor = (e->data.pheromone[*id] > threshold);
+                        }
+                    if (!in_corridor) {
+                        continue;
+                        }
+                    const float d = item.first + e->data.length;
+                    const _t_index v = index(e->end);
+                    if (!settled[v] && d < distance[v]) {
+                        distance[v] = d;
+                        parent[v] = e;
+                        queue.push(std::make_pair(d, v));
+                        }
+                    }
+                }
+            return false;
+            }
+
+        bool corridor_path(const graph_index& index, const graph::_t_node_id& start, const graph::_t_node_id& end,
+                           const std::vector<unsigned int>& pherom_ids, float threshold,
+                           std::vector<edge_ptr>& path) {
+            typedef graph_index::_t_index _t_index;
+
+            path.clear();
+            if (start == end) {
+                return true;
+                }
+            const _t_index source = index.node(start), target = index.node(end);
+            if (source == graph_index::npos || target == graph_index::npos) {
+                return false;
+                }
+
+            const std::vector<edge_ptr>& edges = index.get_edges();
+            lazy_evaporation* evaporation = lazy_evaporation::current();
+            auto in_corridor = [&](std::size_t e) {
+                const edge_ptr& edge = edges[e];
+                if (edge_removed(*edge)) {
+                    return false;
+                    }
+                if (evaporation) {
+                    evaporation->touch(edge.get());
+                    }
+                for (auto id = pherom_ids.begin(); id != pherom_ids.end(); ++id) {
+                    if (edge->data.pheromone[*id] > threshold) {
+                        return true;
+                        }
+                    }
+                return false;
+                };
+
+            // Expand the side with the closest frontier until no path through it can beat the best meeting
+            frontier forward, backward;
+            forward.push(source, 0.f, frontier::no_edge);
+            backward.push(target, 0.f, frontier::no_edge);
+            float best = (std::numeric_limits<float>::infinity)();
+            std::size_t meeting = frontier::no_edge;
+            while (forward.top() + backward.top() < best) {
+                const bool is_forward = forward.top() <= backward.top();
+                frontier& side = is_forward ? forward : backward;
+                const frontier& other = is_forward ? backward : forward;
+                _t_index u;
+                float d;
+                if (!side.pop(u, d)) {
+                    continue; // only stale entries were left: 'top' is infinite now
+                    }
+                auto relax = [&](std::size_t e, _t_index v) {
+                    if (!in_corridor(e)) {
+                        return;
+                        }
+                    const float dv = d + edges[e]->data.length;
+                    side.push(v, dv, e);
+                    if (const float* rest = other.distance(v)) {
+                        if (dv + *rest < best) {
+                            best = dv + *rest;
+                            meeting = e;
+                            }
+                        }
+                    };
+                if (is_forward) {
+                    for (std::size_t e = index.out_begin(u); e != index.out_end(u); ++e) {
+                        relax(e, index.edge_end(e));
+                        }
+                    const std::vector<_t_index>& inserted = index.inserted_out(u);
+                    for (auto e = inserted.begin(); e != inserted.end(); ++e) {
+                        relax(*e, index.edge_end(*e));
+                        }
+                    }
+                else {
+                    for (const _t_index* e = index.in_begin(u); e != index.in_end(u); ++e) {
+                        relax(*e, index.edge_init(*e));
+                        }
+                    const std::vector<_t_index>& inserted = index.inserted_in(u);
+                    for (auto e = inserted.begin(); e != inserted.end(); ++e) {
+                        relax(*e, index.edge_init(*e));
+                        }
+                    }
+                }
+            if (meeting == frontier::no_edge) {
+                return false;
+                }
+
+            // start -> ... -> init(meeting) -> end(meeting) -> ... -> end
+            for (_t_index v = index.edge_init(meeting); v != source; v = index.edge_init(forward.edge(v))) {
+                path.push_back(edges[forward.edge(v)]);
+                }
+            std::reverse(path.begin(), path.end());
+            path.push_back(edges[meeting]);
+            for (_t_index v = index.edge_end(meeting); v != target; v = index.edge_end(backward.edge(v))) {
+                path.push_back(edges[backward.edge(v)]);
+                }
+            return true;
+            }
+
+        }
+    }
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+
+#include "jgsogo/AnCO/graph/graph.h"
+#include "graph_index.h"
+
+namespace AnCO {
+
+    namespace algorithm {
+
+        /*
+        Exact shortest path (by 'data.length') from 'start' to 'end' using only
+        the edges of the corridor: those where any of the colonies 'pherom_ids'
+        has deposited more than 'threshold' (the colonies of a meta-path, see
+        'search_query::make_objectives'). Dijkstra over the out-edges given by
+        'get_feasible_edges'; nodes are indexed on the fly, so the cost grows
+        with the size of the corridor, not of the graph.
+
+        Removed edges (infinite length, see 'graph_updates') are never taken;
+        edges inserted by 'graph_updates' are only known to the 'graph_index'
+        overload below.
+
+        Returns false (and an empty path) if 'end' is not reachable inside the
+        corridor. The caller must keep the pheromone still while it runs.
+        */
+        bool corridor_path(graph& graph, const graph::_t_node_id& start, const graph::_t_node_id& end,
+                           const std::vector<unsigned int>& pherom_ids, float threshold,
+                           std::vector<edge_ptr>& path);
+
+        // The same over the graph numbered by 'index', bidirectional: one Dijkstra from 'start' over the
+        //  out-edges and one from 'end' over the in-edges (reverse adjacency of the index) meet halfway, so
+        //  each one only explores about half of the corridor. Edges inserted into 'index' are walked too.
+        bool corridor_path(const graph_index& index, const graph::_t_node_id& start, const graph::_t_node_id& end,
+                           const std::vector<unsigned int>& pherom_ids, float threshold,
+                           std::vector<edge_ptr>& path);
+
+        }
+    }
@@ -0,0 +1,35 @@
+
+#include "counter_rng.h"
+
+#include <atomic>
+#include <cassert>
+
+namespace AnCO {
+
+    namespace {
+        std::atomic<std::uint64_t> run_seed(0);
+        std::atomic<std::uint32_t> next_ant[N_MAX_COLONIES]; // ants launched by every colony
+        }
+
+    void random_streams::seed(std::uint64_t s) {
+        run_seed.store(s);
+        for (std::size_t c = 0; c<N_MAX_COLONIES; ++c) {
+            next_ant[c].store(0);
+            }
+        }
+
+    counter_rng random_streams::ant(std::uint32_t colony) {
+        assert(colony < N_MAX_COLONIES);
+        return counter_rng(seed(), colony, next_ant[colony].fetch_add(1, std::memory_order_relaxed));
+        }
+
+    std::uint64_t random_streams::seed() {
+        return run_seed.load(std::memory_order_relaxed);
+        }
+
+    std::recursive_mutex& library_rng_mutex() {
+        static std::recursive_mutex mutex;
+        return mutex;
+        }
+
+    }
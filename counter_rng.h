@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+namespace AnCO {
+
+    /*
+    Counter-based random numbers (Philox4x32-10, Salmon et al. 2011): every
+    draw is a pure function of a 64-bit key and a 128-bit counter, so there is
+    no shared state to contend for and the value does not depend on which
+    thread asks for it. The key is the run seed and the counter is
+    (stream, ant, step, block of 4 draws):
+
+        counter_rng rng(seed, colony_id, ant);
+        rng.at(step);
+        std::uint32_t i = rng.below(feasible.size());
+
+    Any (seed, colony, ant, step) can be replayed on its own.
+    */
+    class counter_rng {
+        public:
+            counter_rng(std::uint64_t seed = 0, std::uint32_t stream = 0, std::uint32_t ant = 0) : used(4) {
+                key[0] = std::uint32_t(seed);
+                key[1] = std::uint32_t(seed >> 32);
+                counter[0] = stream;
+                counter[1] = ant;
+                counter[2] = 0;
+                counter[3] = 0;
+                };
+
+            // Jump to 'step' of this ant (the draws of a step don't depend on the previous ones).
+            void at(std::uint32_t step) { counter[2] = step; counter[3] = 0; used = 4; };
+
+            std::uint32_t next() {
+                if (used == 4) {
+                    philox(counter, key, block);
+                    ++counter[3];
+                    used = 0;
+                    }
+                return block[used++];
+                };
+            // Uniform in [0, 1)
+            float uniform() { return float(this->next() >> 8) * (1.f/16777216.f); };
+            // Uniform in [0, n) without division or rejection loop (multiply-high, bias < n/2^32)
+            std::uint32_t below(std::uint32_t n) { return std::uint32_t((std::uint64_t(this->next()) * n) >> 32); };
+
+            static void philox(const std::uint32_t ctr[4], const std::uint32_t k[2], std::uint32_t out[4]) {
+                std::uint32_t x0 = ctr[0], x1 = ctr[1], x2 = ctr[2], x3 = ctr[3];
+                std::uint32_t k0 = k[0], k1 = k[1];
+                for (int round = 0; round<10; ++round) {
+                    const std::uint64_t p0 = std::uint64_t(0xD2511F53u) * x0;
+                    const std::uint64_t p1 = std::uint64_t(0xCD9E8D57u) * x2;
+                    const std::uint32_t y0 = std::uint32_t(p1 >> 32) ^ x1 ^ k0;
+                    const std::uint32_t y2 = std::uint32_t(p0 >> 32) ^ x3 ^ k1;
+                    x1 = std::uint32_t(p1);
+                    x3 = std::uint32_t(p0);
+                    x0 = y0;
+                    x2 = y2;
+                    k0 += 0x9E3779B9u;
+                    k1 += 0xBB67AE85u;
+                    }
+                out[0] = x0; out[1] = x1; out[2] = x2; out[3] = x3;
+                };
+
+        protected:
+            std::uint32_t key[2];
+            std::uint32_t counter[4];
+            std::uint32_t block[4];
+            unsigned int used;
+        };
+
+    /*
+    Seed of the run and the streams drawn from it: one per colony (its
+    pheromone id) and ant, and the ones of our own code (e.g. the start/end
+    nodes of a run). The n-th ant a colony launches gets stream
+    '(colony, n)' ('ant'): colonies run concurrently, but each one launches
+    its ants in order, so the numbers an ant gets don't depend on the
+    number of threads. 'seed' starts every colony at its first ant again.
+    */
+    class random_streams {
+        public:
+            // Streams that are not colonies ('stream' values above any pheromone id)
+            enum : std::uint32_t { stream_nodes = 0xFFFFFF00u };
+
+            static void seed(std::uint64_t s);
+            static std::uint64_t seed();
+
+            static counter_rng stream(std::uint32_t stream, std::uint32_t ant = 0) { return counter_rng(seed(), stream, ant); };
+            // Stream of the next ant of colony 'colony' (a pheromone id, below N_MAX_COLONIES).
+            static counter_rng ant(std::uint32_t colony);
+        };
+
+    // True for the ACO algorithms that take every random number from 'random_streams' (see
+    //  'aco_random_streams'); colonies of the others share the generator of the library ('parallel_run').
+    template <class aco_algorithm>
+    struct draws_from_streams {
+        static const bool value = false;
+        };
+
+    // The generator of the library is shared and not thread-safe: 'parallel_run' holds this lock while
+    //  the colonies that draw from it run, and any other call into the library that draws from it takes
+    //  it as well (recursive: a colony run under it may draw again through one of our algorithms).
+    std::recursive_mutex& library_rng_mutex();
+
+    }
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+namespace AnCO {
+
+    /*
+    Open-addressing (linear probing) set of 64-bit fingerprints. Zero marks an
+    empty slot, so a zero fingerprint is stored as one. The table doubles when
+    it is half full; lookups and inserts never allocate otherwise.
+    */
+    class fingerprint_set {
+        public:
+            fingerprint_set(std::size_t capacity = 1024) : n(0) {
+                std::size_t c = 16;
+                while (c < 2*capacity) c <<= 1;
+                slots.assign(c, 0);
+                };
+
+            // Returns true if 'fp' was not already in the set.
+            bool insert(std::uint64_t fp) {
+                if (2*(n+1) > slots.size()) {
+                    this->grow();
+                    }
+                return this->insert_slot(slots, fp ? fp : 1);
+                };
+
+            bool contains(std::uint64_t fp) const {
+                fp = fp ? fp : 1;
+                const std::size_t mask = slots.size()-1;
+                for (std::size_t i = std::size_t(fp) & mask; slots[i]; i = (i+1) & mask) {
+                    if (slots[i] == fp) return true;
+                    }
+                return false;
+                };
+
+            std::size_t size() const { return n; };
+            void clear() { slots.assign(slots.size(), 0); n = 0; };
+            void swap(fingerprint_set& other) { slots.swap(other.slots); std::swap(n, other.n); };
+
+        protected:
+            bool insert_slot(std::vector<std::uint64_t>& table, std::uint64_t fp) {
+                const std::size_t mask = table.size()-1;
+                std::size_t i = std::size_t(fp) & mask;
+                for (; table[i]; i = (i+1) & mask) {
+                    if (table[i] == fp) return false;
+                    }
+                table[i] = fp;
+                ++n;
+                return true;
+                };
+
+            void grow() {
+                std::vector<std::uint64_t> table(2*slots.size(), 0);
+                n = 0;
+                for (auto it = slots.begin(); it != slots.end(); ++it) {
+                    if (*it) this->insert_slot(table, *it);
+                    }
+                slots.swap(table);
+                };
+
+            std::vector<std::uint64_t> slots;
+            std::size_t n;
+        };
+
+    /*
+    Fingerprints seen recently: two generations of at most 'generation'
+    fingerprints each. When the current one is full it becomes the previous
+    one and the oldest is dropped, so memory is bounded whatever the number
+    of insertions; a fingerprint not seen for that long is new again.
+    */
+    class fingerprint_window {
+        public:
+            fingerprint_window(std::size_t generation = 16384) : generation((std::max)(std::size_t(1), generation)), n_inserted(0) {};
+
+            // Returns true if 'fp' is not in the window (and adds it).
+            bool insert(std::uint64_t fp) {
+                if (current.contains(fp) || previous.contains(fp)) {
+                    return false;
+                    }
+                if (current.size() == generation) {
+                    previous.swap(current);
+                    current.clear();
+                    }
+                current.insert(fp);
+                ++n_inserted;
+                return true;
+                };
+
+            bool contains(std::uint64_t fp) const { return current.contains(fp) || previous.contains(fp); };
+            std::size_t size() const { return current.size() + previous.size(); };
+            // Insertions that returned true since construction (grows with every new fingerprint).
+            std::size_t inserted() const { return n_inserted; };
+
+        protected:
+            std::size_t generation;
+            fingerprint_set current, previous;
+            std::size_t n_inserted;
+        };
+
+    // Incremental fingerprint of a path: mixes the hash of every node as the path grows.
+    inline std::uint64_t fingerprint_mix(std::uint64_t h, std::uint64_t node_hash) {
+        h ^= node_hash + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        // splitmix64 finalizer
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+        }
+
+    }
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+namespace AnCO {
+
+    /*
+    Synthetic graphs for benchmarks. Every generator feeds a builder with
+    'add_edge(init, end, length)' ('graph_data_file_builder' to get a
+    'memgraph', 'graph_snapshot_writer' to dump a snapshot file) and returns
+    the number of nodes; node ids are 'std::to_string(0..n-1)' and edge
+    lengths are uniform in [1, 10). Nodes are added before any edge.
+    */
+    namespace generators {
+
+        typedef std::mt19937_64 _t_rng;
+
+        inline float random_length(_t_rng& rng) {
+            return std::uniform_real_distribution<float>(1.f, 10.f)(rng);
+            }
+
+        template <class builder_t>
+        void add_nodes(builder_t& builder, std::size_t n) {
+            for (std::size_t i = 0; i<n; ++i) {
+                builder.add_node(std::to_string(i));
+                }
+            }
+
+        // 4-neighbour grid, both directions: ~'n_edges' edges.
+        template <class builder_t>
+        std::size_t grid(builder_t& builder, std::size_t n_edges, _t_rng& rng) {
+            const std::size_t side = (std::max)(std::size_t(2), std::size_t(std::sqrt(double(n_edges)/4.)));
+            add_nodes(builder, side*side);
+            for (std::size_t r = 0; r<side; ++r) {
+                for (std::size_t c = 0; c<side; ++c) {
+                    const std::size_t id = r*side + c;
+                    if (c+1 < side) {
+                        builder.add_edge(std::to_string(id), std::to_string(id+1), random_length(rng));
+                        builder.add_edge(std::to_string(id+1), std::to_string(id), random_length(rng));
+                        }
+                    if (r+1 < side) {
+                        builder.add_edge(std::to_string(id), std::to_string(id+side), random_length(rng));
+                        builder.add_edge(std::to_string(id+side), std::to_string(id), random_length(rng));
+                        }
+                    }
+                }
+            return side*side;
+            }
+
+        // Erdos-Renyi G(n, m) with mean out-degree 'degree' (directed, no self loops).
+        template <class builder_t>
+        std::size_t erdos_renyi(builder_t& builder, std::size_t n_edges, _t_rng& rng, std::size_t degree = 8) {
+            const std::size_t n = (std::max)(std::size_t(2), n_edges/degree);
+            add_nodes(builder, n);
+            std::uniform_int_distribution<std::size_t> node(0, n-1);
+            for (std::size_t e = 0; e<n_edges; ++e) {
+                std::size_t i = node(rng), j = node(rng);
+                while (j == i) j = node(rng);
+                builder.add_edge(std::to_string(i), std::to_string(j), random_length(rng));
+                }
+            return n;
+            }
+
+        // Barabasi-Albert preferential attachment: every new node links to 'm' existing ones (both directions).
+        template <class builder_t>
+        std::size_t scale_free(builder_t& builder, std::size_t n_edges, _t_rng& rng, std::size_t m = 4) {
+            const std::size_t n = (std::max)(m+1, n_edges/(2*m));
+            add_nodes(builder, n);
+            std::vector<std::size_t> targets; // every node appears once per incident edge
+            targets.reserve(2*m*n);
+            for (std::size_t i = 0; i<=m; ++i) {
+                for (std::size_t j = 0; j<i; ++j) {
+                    builder.add_edge(std::to_string(i), std::to_string(j), random_length(rng));
+                    builder.add_edge(std::to_string(j), std::to_string(i), random_length(rng));
+                    targets.push_back(i);
+                    targets.push_back(j);
+                    }
+                }
+            for (std::size_t i = m+1; i<n; ++i) {
+                for (std::size_t k = 0; k<m; ++k) {
+                    std::size_t j = targets[std::uniform_int_distribution<std::size_t>(0, targets.size()-1)(rng)];
+                    builder.add_edge(std::to_string(i), std::to_string(j), random_length(rng));
+                    builder.add_edge(std::to_string(j), std::to_string(i), random_length(rng));
+                    targets.push_back(j);
+                    }
+                for (std::size_t k = 0; k<m; ++k) {
+                    targets.push_back(i);
+                    }
+                }
+            return n;
+            }
+
+        }
+    }
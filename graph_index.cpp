@@ -0,0 +1,105 @@
+
+#include "graph_index.h"
+
+#include <set>
+#include <stdexcept>
+
+#include "jgsogo/AnCO/algorithm/aco_base.h"
+
+namespace AnCO {
+
+    namespace {
+        thread_local const graph_index* current_index = nullptr;
+        }
+
+    const graph_index::_t_index graph_index::npos;
+
+    graph_index::scope::scope(const graph_index* index) : previous(current_index) {
+        current_index = index;
+        }
+
+    graph_index::scope::~scope() {
+        current_index = previous;
+        }
+
+    const graph_index* graph_index::current() {
+        return current_index;
+        }
+
+    graph_index::graph_index(const graph_snapshot& snapshot, graph& graph) : snapshot(snapshot), indexed(&graph) {
+        const std::set<graph::_t_node_id> none;
+        std::vector<edge_ptr> out;
+        out_offsets.push_back(0);
+        for (std::size_t i = 0; i<snapshot.n_nodes(); ++i) {
+            out.clear();
+            algorithm::aco_base::get_feasible_edges(graph, snapshot.node_id(_t_index(i)), out, none);
+            for (auto it = out.begin(); it != out.end(); ++it) {
+                const _t_index end = this->node((*it)->end);
+                if (end == npos) {
+                    throw std::runtime_error("graph_index: edge to '" + (*it)->end + "', which is not in the snapshot");
+                    }
+                edges.push_back(*it);
+                inits.push_back(_t_index(i));
+                ends.push_back(end);
+                }
+            out_offsets.push_back(edges.size());
+            }
+
+        // Reverse adjacency (counting sort by end node, snapshot order inside each node)
+        in_offsets.assign(snapshot.n_nodes() + 1, 0);
+        for (std::size_t e = 0; e<edges.size(); ++e) {
+            ++in_offsets[ends[e] + 1];
+            }
+        for (std::size_t i = 0; i<snapshot.n_nodes(); ++i) {
+            in_offsets[i+1] += in_offsets[i];
+            }
+        in_edges.resize(edges.size());
+        std::vector<std::size_t> next(in_offsets.begin(), in_offsets.end() - 1);
+        for (std::size_t e = 0; e<edges.size(); ++e) {
+            in_edges[next[ends[e]]++] = _t_index(e);
+            }
+
+        n_snapshot_edges = edges.size();
+        std::size_t size = 16;
+        while (size < 2*edges.size()) {
+            size <<= 1;
+            }
+        slots.assign(size, _t_slot(nullptr, npos));
+        for (std::size_t e = 0; e<edges.size(); ++e) {
+            this->add_slot(edges[e].get(), _t_index(e));
+            }
+        }
+
+    void graph_index::add_slot(const _t_edge* e, _t_index position) {
+        const std::size_t mask = slots.size() - 1;
+        std::size_t i = hash(e) & mask;
+        while (slots[i].first) {
+            i = (i+1) & mask;
+            }
+        slots[i] = _t_slot(e, position);
+        }
+
+    graph_index::_t_index graph_index::insert(const edge_ptr& e) {
+        const _t_index init = this->node(e->init), end = this->node(e->end);
+        if (init == npos || end == npos) {
+            return npos;
+            }
+        const _t_index position = _t_index(edges.size());
+        edges.push_back(e);
+        inits.push_back(init);
+        ends.push_back(end);
+        inserted_from[init].push_back(position);
+        inserted_to[end].push_back(position);
+        if (2*edges.size() > slots.size()) {
+            slots.assign(2*slots.size(), _t_slot(nullptr, npos));
+            for (std::size_t p = 0; p<edges.size(); ++p) {
+                this->add_slot(edges[p].get(), _t_index(p));
+                }
+            }
+        else {
+            this->add_slot(e.get(), position);
+            }
+        return position;
+        }
+
+    }
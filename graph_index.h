@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+#include "jgsogo/AnCO/graph/graph.h"
+#include "graph_snapshot.h"
+
+namespace AnCO {
+
+    /*
+    Dense numbering of a graph loaded from a 'graph_snapshot', built once and
+    shared by every thread (read-only but for 'insert', between iterations):
+        - node 'i' is the i-th node of the snapshot ('node' looks an id up
+          with a binary search over the mapped ids, nothing is copied),
+        - edges are numbered in snapshot order and 'end' gives the dense
+          index of the end node of an edge of the graph from its address
+          (open addressing over the pointers, no string is hashed),
+        - the edges leaving node 'i' are positions 'out_begin(i)..out_end(i)'
+          and the positions of the ones arriving at it are 'in_begin(i)..
+          in_end(i)' (reverse adjacency, for searches from the end),
+        - edges inserted into the live graph ('insert', see 'graph_updates')
+          take the next positions; they are not in those ranges but in
+          'inserted_out(i)' and 'inserted_in(i)'.
+
+    Ants keep their per-node state in arrays indexed by it; the instance
+    they use is the one installed in their thread by a 'scope' (like
+    'aco_multiobjetivo::objective_scope').
+    */
+    class graph_index {
+        public:
+            typedef graph_snapshot::_t_index _t_index;
+            typedef edge_ptr::element_type _t_edge;
+            static const _t_index npos = ~_t_index(0);
+
+            graph_index(const graph_snapshot& snapshot, graph& graph);
+
+            const graph_snapshot& get_snapshot() const { return snapshot; };
+            // This is the numbering of 'g' (and not of another graph walked by the same thread).
+            bool indexes(const graph& g) const { return &g == indexed; };
+            std::size_t n_nodes() const { return snapshot.n_nodes(); };
+            std::size_t n_edges() const { return edges.size(); };
+
+            // Dense index of node 'id' ('npos' if it is not in the graph).
+            _t_index node(const graph::_t_node_id& id) const {
+                _t_index i;
+                return snapshot.find(id, i) ? i : npos;
+                };
+            // Position of 'e' in snapshot order and dense index of its end node ('npos' if it is not an edge of the graph).
+            _t_index edge(const _t_edge* e) const { return this->lookup(e).second; };
+            _t_index end(const _t_edge* e) const {
+                const _t_index i = this->edge(e);
+                return (i == npos) ? npos : ends[i];
+                };
+            const std::vector<edge_ptr>& get_edges() const { return edges; };
+
+            // Adds an edge between two nodes of the snapshot (the library graph can't take it). Caller holds
+            //  the pipeline mutex: no ant is walking. Returns its position, 'npos' if a node is unknown.
+            _t_index insert(const edge_ptr& e);
+            std::size_t n_inserted() const { return edges.size() - n_snapshot_edges; };
+
+            // Adjacency by position (snapshot order): both ends of edge 'e', edges out of and into node 'i'.
+            _t_index edge_init(std::size_t e) const { return inits[e]; };
+            _t_index edge_end(std::size_t e) const { return ends[e]; };
+            std::size_t out_begin(_t_index i) const { return out_offsets[i]; };
+            std::size_t out_end(_t_index i) const { return out_offsets[i+1]; };
+            const _t_index* in_begin(_t_index i) const { return in_edges.data() + in_offsets[i]; };
+            const _t_index* in_end(_t_index i) const { return in_edges.data() + in_offsets[i+1]; };
+            const std::vector<_t_index>& inserted_out(_t_index i) const { return this->inserted(inserted_from, i); };
+            const std::vector<_t_index>& inserted_in(_t_index i) const { return this->inserted(inserted_to, i); };
+
+            class scope {
+                public:
+                    scope(const graph_index* index);
+                    ~scope();
+                private:
+                    scope(const scope&);
+                    scope& operator=(const scope&);
+                    const graph_index* previous;
+                };
+            static const graph_index* current();
+
+        protected:
+            typedef std::pair<const _t_edge*, _t_index> _t_slot;
+
+            static std::size_t hash(const _t_edge* e) {
+                std::uint64_t h = std::uint64_t(reinterpret_cast<std::uintptr_t>(e));
+                h ^= h >> 33;
+                h *= 0xff51afd7ed558ccdULL;
+                return std::size_t(h ^ (h >> 33));
+                };
+            const _t_slot& lookup(const _t_edge* e) const {
+                const std::size_t mask = slots.size() - 1;
+                std::size_t i = hash(e) & mask;
+                while (slots[i].first && slots[i].first != e) {
+                    i = (i+1) & mask;
+                    }
+                return slots[i];
+                };
+            void add_slot(const _t_edge* e, _t_index position);
+            typedef std::unordered_map<_t_index, std::vector<_t_index>> _t_inserted;
+            const std::vector<_t_index>& inserted(const _t_inserted& by_node, _t_index i) const {
+                static const std::vector<_t_index> none;
+                auto it = by_node.find(i);
+                return (it == by_node.end()) ? none : it->second;
+                };
+
+            const graph_snapshot& snapshot;
+            const graph* indexed;
+            std::vector<edge_ptr> edges;        // snapshot order
+            std::vector<_t_index> inits, ends;  // dense index of the nodes of every edge
+            std::vector<std::size_t> out_offsets, in_offsets; // n_nodes+1
+            std::vector<_t_index> in_edges;     // positions of the edges, by end node
+            std::vector<_t_slot> slots;         // edge address -> position (power of two, at most half full)
+            std::size_t n_snapshot_edges;
+            _t_inserted inserted_from, inserted_to; // positions of the inserted edges, by init/end node
+        };
+
+    }
@@ -0,0 +1,420 @@
+
+#include "graph_snapshot.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <set>
+#include <cstdio>
+
+#include "jgsogo/AnCO/algorithm/aco_base.h"
+
+#ifdef _WINDOWS
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace AnCO {
+
+    namespace {
+        const char snapshot_magic[8] = {'A', 'n', 'C', 'O', 'S', 'N', 'A', 'P'};
+
+        std::uint64_t align8(std::uint64_t offset) {
+            return (offset + 7) & ~std::uint64_t(7);
+            }
+
+        // 'count' items of 'item_size' bytes at 'offset' are inside a file of 'size' bytes (after the header)
+        bool section_fits(std::uint64_t offset, std::uint64_t count, std::uint64_t item_size, std::uint64_t size) {
+            return offset >= sizeof(graph_snapshot::header) && offset % 8 == 0 && offset <= size
+                && count <= (size - offset) / item_size;
+            }
+
+        bool file_exists(const std::string& filename, long long& mtime) {
+            #ifdef _WINDOWS
+                WIN32_FILE_ATTRIBUTE_DATA attrs;
+                if (!GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &attrs)) {
+                    return false;
+                    }
+                mtime = (static_cast<long long>(attrs.ftLastWriteTime.dwHighDateTime) << 32) | attrs.ftLastWriteTime.dwLowDateTime;
+            #else
+                struct stat st;
+                if (stat(filename.c_str(), &st) != 0) {
+                    return false;
+                    }
+                mtime = static_cast<long long>(st.st_mtime);
+            #endif
+            return true;
+            }
+
+        // Atomic rename over an existing file (std::rename fails on Windows if 'to' exists)
+        bool replace_file(const std::string& from, const std::string& to) {
+            #ifdef _WINDOWS
+                return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+            #else
+                return std::rename(from.c_str(), to.c_str()) == 0;
+            #endif
+            }
+
+        // Name of the file a process writes before renaming it over 'filename'
+        std::string temporary_name(const std::string& filename) {
+            #ifdef _WINDOWS
+                const unsigned long pid = GetCurrentProcessId();
+            #else
+                const unsigned long pid = static_cast<unsigned long>(getpid());
+            #endif
+            return filename + ".tmp." + std::to_string(pid);
+            }
+        }
+
+    graph_snapshot::graph_snapshot() : _data(nullptr), _size(0),
+        #ifdef _WINDOWS
+            _file(nullptr), _mapping(nullptr),
+        #endif
+        _header(nullptr), _offsets(nullptr), _targets(nullptr), _lengths(nullptr), _id_offsets(nullptr), _id_order(nullptr), _id_chars(nullptr) {
+        }
+
+    graph_snapshot::~graph_snapshot() {
+        this->close();
+        }
+
+    void graph_snapshot::open(const std::string& filename) {
+        this->close();
+        #ifdef _WINDOWS
+            HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            if (file == INVALID_HANDLE_VALUE) {
+                throw std::runtime_error("graph_snapshot: cannot open '" + filename + "'");
+                }
+            LARGE_INTEGER size;
+            GetFileSizeEx(file, &size);
+            HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+            if (!data) {
+                if (mapping) CloseHandle(mapping);
+                CloseHandle(file);
+                throw std::runtime_error("graph_snapshot: cannot map '" + filename + "'");
+                }
+            _file = file;
+            _mapping = mapping;
+            _data = data;
+            _size = static_cast<std::size_t>(size.QuadPart);
+        #else
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("graph_snapshot: cannot open '" + filename + "'");
+                }
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size == 0) {
+                ::close(fd);
+                throw std::runtime_error("graph_snapshot: cannot stat '" + filename + "'");
+                }
+            void* data = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (data == MAP_FAILED) {
+                throw std::runtime_error("graph_snapshot: cannot map '" + filename + "'");
+                }
+            _data = data;
+            _size = static_cast<std::size_t>(st.st_size);
+        #endif
+
+        const char* base = static_cast<const char*>(_data);
+        _header = reinterpret_cast<const header*>(base);
+        if (_size < sizeof(header) || std::memcmp(_header->magic, snapshot_magic, sizeof(snapshot_magic)) != 0
+            || _header->version != graph_snapshot::version || _header->file_size != _size) {
+            this->close();
+            throw std::runtime_error("graph_snapshot: '" + filename + "' is not a valid snapshot");
+            }
+
+        // Sections inside the file and counts that agree with them (only the ends of the
+        //  offset tables are read here: checking every entry would fault in the whole file,
+        //  'load_into' does it while it reads them)
+        const header& h = *_header;
+        const std::uint64_t size = _size;
+        bool valid = h.n_nodes < (std::numeric_limits<_t_index>::max)() && h.n_edges <= (std::numeric_limits<_t_index>::max)()
+            && section_fits(h.edge_offsets, h.n_nodes + 1, sizeof(std::uint64_t), size)
+            && section_fits(h.edge_targets, h.n_edges, sizeof(std::uint32_t), size)
+            && section_fits(h.edge_lengths, h.n_edges, sizeof(float), size)
+            && section_fits(h.id_offsets, h.n_nodes + 1, sizeof(std::uint64_t), size)
+            && section_fits(h.id_order, h.n_nodes, sizeof(std::uint32_t), size)
+            && section_fits(h.id_chars, 0, 1, size);
+        if (valid) {
+            _offsets = reinterpret_cast<const std::uint64_t*>(base + h.edge_offsets);
+            _id_offsets = reinterpret_cast<const std::uint64_t*>(base + h.id_offsets);
+            valid = _offsets[0] == 0 && _offsets[h.n_nodes] == h.n_edges
+                && _id_offsets[0] == 0 && _id_offsets[h.n_nodes] == size - h.id_chars;
+            }
+        if (!valid) {
+            this->close();
+            throw std::runtime_error("graph_snapshot: '" + filename + "' is truncated or corrupt");
+            }
+        _targets = reinterpret_cast<const std::uint32_t*>(base + h.edge_targets);
+        _lengths = reinterpret_cast<const float*>(base + h.edge_lengths);
+        _id_order = reinterpret_cast<const std::uint32_t*>(base + h.id_order);
+        _id_chars = base + h.id_chars;
+        }
+
+    void graph_snapshot::close() {
+        if (_data) {
+            #ifdef _WINDOWS
+                UnmapViewOfFile(_data);
+                CloseHandle(_mapping);
+                CloseHandle(_file);
+                _file = nullptr;
+                _mapping = nullptr;
+            #else
+                munmap(_data, _size);
+            #endif
+            }
+        _data = nullptr;
+        _size = 0;
+        _header = nullptr;
+        _offsets = nullptr;
+        _targets = nullptr;
+        _lengths = nullptr;
+        _id_offsets = nullptr;
+        _id_order = nullptr;
+        _id_chars = nullptr;
+        }
+
+    graph::_t_node_id graph_snapshot::node_id(_t_index node) const {
+        return graph::_t_node_id(_id_chars + _id_offsets[node], _id_chars + _id_offsets[node+1]);
+        }
+
+    bool graph_snapshot::find(const graph::_t_node_id& id, _t_index& node) const {
+        std::size_t lo = 0, hi = this->n_nodes();
+        while (lo < hi) {
+            const std::size_t mid = lo + (hi - lo)/2;
+            const _t_index i = _id_order[mid];
+            if (i >= this->n_nodes()) {
+                return false; // corrupt table (checked by 'load_into', not by 'open')
+                }
+            const char* begin = _id_chars + _id_offsets[i];
+            const std::size_t size = std::size_t(_id_offsets[i+1] - _id_offsets[i]);
+            const int cmp = id.compare(0, id.size(), begin, size);
+            if (cmp == 0) {
+                node = i;
+                return true;
+                }
+            if (cmp > 0) {
+                lo = mid + 1;
+                }
+            else {
+                hi = mid;
+                }
+            }
+        return false;
+        }
+
+    void graph_snapshot::validate() const {
+        const std::size_t n = this->n_nodes();
+        const std::uint64_t n_chars = _size - _header->id_chars;
+        std::vector<bool> listed(n, false);
+        for (std::size_t i = 0; i<n; ++i) {
+            const std::uint32_t j = _id_order[i];
+            if (_offsets[i] > _offsets[i+1] || _id_offsets[i] > _id_offsets[i+1] || _id_offsets[i+1] > n_chars
+                || j >= n || listed[j]) {
+                throw std::runtime_error("graph_snapshot: corrupt offsets or id order at node " + std::to_string(i));
+                }
+            listed[j] = true;
+            }
+        const std::size_t n_edges = this->n_edges();
+        for (std::size_t e = 0; e<n_edges; ++e) {
+            if (_targets[e] >= n) {
+                throw std::runtime_error("graph_snapshot: corrupt target at edge " + std::to_string(e));
+                }
+            }
+        }
+
+    void graph_snapshot::load_into(graph_data_file_builder& builder) const {
+        // Every entry is read below anyway: check them all before anything reaches the builder
+        this->validate();
+        // Ids are read from the mapping as they are needed, no table of them is kept
+        const std::size_t n = this->n_nodes();
+        for (std::size_t i = 0; i<n; ++i) {
+            builder.add_node(this->node_id(_t_index(i)));
+            }
+        for (std::size_t i = 0; i<n; ++i) {
+            const graph::_t_node_id init = this->node_id(_t_index(i));
+            for (auto it = this->edges_begin(_t_index(i)); it != this->edges_end(_t_index(i)); ++it) {
+                builder.add_edge(init, this->node_id(*it), _lengths[this->edge_index(it)]);
+                }
+            }
+        }
+
+    std::unique_ptr<memgraph> graph_snapshot::make_graph() const {
+        std::unique_ptr<graph_data_file_builder> builder(new graph_data_file_builder());
+        this->load_into(*builder);
+        std::unique_ptr<memgraph> graph(new memgraph(*builder));
+        return graph; // the builder (a second copy of the whole graph) goes away here
+        }
+
+    std::size_t graph_snapshot::check(graph& graph) const {
+        const std::set<graph::_t_node_id> none;
+        std::vector<edge_ptr> out;
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i<this->n_nodes(); ++i) {
+            std::vector<std::pair<graph::_t_node_id, float>> expected, found;
+            for (auto it = this->edges_begin(_t_index(i)); it != this->edges_end(_t_index(i)); ++it) {
+                expected.push_back(std::make_pair(this->node_id(*it), _lengths[this->edge_index(it)]));
+                }
+            out.clear();
+            algorithm::aco_base::get_feasible_edges(graph, this->node_id(_t_index(i)), out, none);
+            for (auto it = out.begin(); it != out.end(); ++it) {
+                found.push_back(std::make_pair((*it)->end, (*it)->data.length));
+                }
+            std::sort(expected.begin(), expected.end());
+            std::sort(found.begin(), found.end());
+            mismatches += (expected != found) ? 1 : 0;
+            }
+        return mismatches;
+        }
+
+    bool graph_snapshot::is_snapshot(const std::string& filename) {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        char magic[sizeof(snapshot_magic)];
+        return file.read(magic, sizeof(magic)) && (std::memcmp(magic, snapshot_magic, sizeof(magic)) == 0);
+        }
+
+    bool graph_snapshot::is_current(const std::string& filename) {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        header h;
+        return file.read(reinterpret_cast<char*>(&h), sizeof(h)) && (std::memcmp(h.magic, snapshot_magic, sizeof(snapshot_magic)) == 0)
+            && h.version == graph_snapshot::version;
+        }
+
+    void graph_snapshot::convert(const std::string& text_file, const std::string& snapshot_file) {
+        std::ifstream file(text_file.c_str());
+        if (!file) {
+            throw std::runtime_error("graph_snapshot: cannot open '" + text_file + "'");
+            }
+        graph_snapshot_writer writer;
+        std::string line;
+        graph::_t_node_id init, end;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#' || line[0] == '%') {
+                continue;
+                }
+            std::istringstream is(line);
+            float length;
+            if (!(is >> init >> end)) {
+                continue;
+                }
+            writer.add_edge(init, end, (is >> length) ? length : 1.f);
+            }
+        writer.write(snapshot_file);
+        }
+
+    std::string graph_snapshot::ensure(const std::string& dataset) {
+        if (graph_snapshot::is_snapshot(dataset)) {
+            return dataset;
+            }
+        std::string snapshot_file = dataset + ".snapshot";
+        long long text_time = 0, snapshot_time = 0;
+        if (!file_exists(snapshot_file, snapshot_time) || (file_exists(dataset, text_time) && text_time > snapshot_time)
+            || !graph_snapshot::is_current(snapshot_file)) {
+            graph_snapshot::convert(dataset, snapshot_file);
+            }
+        return snapshot_file;
+        }
+
+
+    graph_snapshot::_t_index graph_snapshot_writer::add_node(const graph::_t_node_id& id) {
+        auto it = index.find(id);
+        if (it != index.end()) {
+            return it->second;
+            }
+        graph_snapshot::_t_index i = graph_snapshot::_t_index(ids.size());
+        index.insert(std::make_pair(id, i));
+        ids.push_back(id);
+        return i;
+        }
+
+    void graph_snapshot_writer::add_edge(const graph::_t_node_id& init, const graph::_t_node_id& end, float length) {
+        graph_snapshot::_t_index i = this->add_node(init);
+        graph_snapshot::_t_index j = this->add_node(end);
+        edges.push_back(std::make_pair(i, std::make_pair(j, length)));
+        }
+
+    void graph_snapshot_writer::write(const std::string& filename) const {
+        const std::uint64_t n_nodes = ids.size();
+        const std::uint64_t n_edges = edges.size();
+
+        // CSR, stable on the input order of the edges of each node.
+        std::vector<std::uint64_t> offsets(n_nodes+1, 0);
+        for (auto it = edges.begin(); it != edges.end(); ++it) {
+            ++offsets[it->first+1];
+            }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        std::vector<std::uint32_t> targets(n_edges);
+        std::vector<float> lengths(n_edges);
+        std::vector<std::uint64_t> cursor(offsets.begin(), offsets.end()-1);
+        for (auto it = edges.begin(); it != edges.end(); ++it) {
+            std::uint64_t pos = cursor[it->first]++;
+            targets[pos] = it->second.first;
+            lengths[pos] = it->second.second;
+            }
+
+        std::vector<std::uint64_t> id_offsets(n_nodes+1, 0);
+        for (std::size_t i = 0; i<ids.size(); ++i) {
+            id_offsets[i+1] = id_offsets[i] + ids[i].size();
+            }
+        std::vector<std::uint32_t> id_order(n_nodes);
+        std::iota(id_order.begin(), id_order.end(), std::uint32_t(0));
+        std::sort(id_order.begin(), id_order.end(), [this](std::uint32_t a, std::uint32_t b){ return ids[a] < ids[b]; });
+
+        graph_snapshot::header h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, snapshot_magic, sizeof(snapshot_magic));
+        h.version = graph_snapshot::version;
+        h.n_nodes = n_nodes;
+        h.n_edges = n_edges;
+        h.edge_offsets = align8(sizeof(h));
+        h.edge_targets = align8(h.edge_offsets + offsets.size()*sizeof(std::uint64_t));
+        h.edge_lengths = align8(h.edge_targets + targets.size()*sizeof(std::uint32_t));
+        h.id_offsets = align8(h.edge_lengths + lengths.size()*sizeof(float));
+        h.id_order = align8(h.id_offsets + id_offsets.size()*sizeof(std::uint64_t));
+        h.id_chars = align8(h.id_order + id_order.size()*sizeof(std::uint32_t));
+        h.file_size = h.id_chars + id_offsets.back();
+
+        // Written aside and renamed over 'filename': a process that opens it meanwhile maps the old file or the new one, never half of it
+        const std::string tmp = temporary_name(filename);
+        std::ofstream file(tmp.c_str(), std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("graph_snapshot: cannot write '" + tmp + "'");
+            }
+        std::uint64_t pos = 0;
+        auto write_at = [&file, &pos](std::uint64_t offset, const void* data, std::size_t size) {
+            static const char padding[8] = {0};
+            file.write(padding, offset - pos);
+            file.write(static_cast<const char*>(data), size);
+            pos = offset + size;
+            };
+        write_at(0, &h, sizeof(h));
+        write_at(h.edge_offsets, offsets.data(), offsets.size()*sizeof(std::uint64_t));
+        write_at(h.edge_targets, targets.data(), targets.size()*sizeof(std::uint32_t));
+        write_at(h.edge_lengths, lengths.data(), lengths.size()*sizeof(float));
+        write_at(h.id_offsets, id_offsets.data(), id_offsets.size()*sizeof(std::uint64_t));
+        write_at(h.id_order, id_order.data(), id_order.size()*sizeof(std::uint32_t));
+        write_at(h.id_chars, nullptr, 0);
+        for (auto it = ids.begin(); it != ids.end(); ++it) {
+            file.write(it->data(), it->size());
+            }
+        file.close();
+        if (!file) {
+            std::remove(tmp.c_str());
+            throw std::runtime_error("graph_snapshot: error writing '" + tmp + "'");
+            }
+        if (!replace_file(tmp, filename)) {
+            std::remove(tmp.c_str());
+            throw std::runtime_error("graph_snapshot: cannot rename '" + tmp + "' to '" + filename + "'");
+            }
+        }
+
+    }
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+#include "jgsogo/AnCO/graph/graph.h"
+#include "jgsogo/AnCO/graph/graph_data_file.h"
+#include "jgsogo/AnCO/graph/memgraph.h"
+
+namespace AnCO {
+
+    /*
+    Binary snapshot of a graph dataset: node-id table, CSR adjacency and edge lengths.
+
+    File layout (native endianness, every section aligned to 8 bytes):
+        header
+        uint64_t  edge_offsets[n_nodes+1]  // CSR row pointers
+        uint32_t  edge_targets[n_edges]    // dense index of the 'end' node
+        float     edge_lengths[n_edges]
+        uint64_t  id_offsets[n_nodes+1]    // into 'id_chars'
+        uint32_t  id_order[n_nodes]        // dense indexes sorted by node id (lookups)
+        char      id_chars[]               // node ids, not null-terminated
+
+    The file is mmap-ed read-only, so opening it only costs the page faults of
+    the sections actually touched; 'open' checks that every section lies
+    inside the file and agrees with the counts of the header, 'load_into'
+    checks every entry (offsets that don't decrease, targets and id order
+    inside the nodes) before it feeds the builder. Lookups on a snapshot that
+    has not been loaded rely on 'open' alone.
+    */
+    class graph_snapshot {
+        public:
+            typedef std::uint32_t _t_index;
+
+            struct header {
+                char magic[8];
+                std::uint32_t version;
+                std::uint32_t reserved;
+                std::uint64_t n_nodes;
+                std::uint64_t n_edges;
+                std::uint64_t edge_offsets;
+                std::uint64_t edge_targets;
+                std::uint64_t edge_lengths;
+                std::uint64_t id_offsets;
+                std::uint64_t id_order;
+                std::uint64_t id_chars;
+                std::uint64_t file_size;
+                };
+
+            static const std::uint32_t version = 2;
+
+            graph_snapshot();
+            ~graph_snapshot();
+
+            // Maps 'filename' in memory (throws std::runtime_error if it is not a valid snapshot).
+            void open(const std::string& filename);
+            void close();
+            bool is_open() const { return _data != nullptr; };
+
+            std::size_t n_nodes() const { return _header ? std::size_t(_header->n_nodes) : 0; };
+            std::size_t n_edges() const { return _header ? std::size_t(_header->n_edges) : 0; };
+
+            graph::_t_node_id node_id(_t_index node) const;
+            // Dense index of node 'id' (binary search over the ids, nothing is copied); false if it is not in the graph.
+            bool find(const graph::_t_node_id& id, _t_index& node) const;
+            const std::uint32_t* edges_begin(_t_index node) const { return _targets + _offsets[node]; };
+            const std::uint32_t* edges_end(_t_index node) const { return _targets + _offsets[node+1]; };
+            float edge_length(std::size_t edge) const { return _lengths[edge]; };
+            std::size_t edge_index(const std::uint32_t* it) const { return it - _targets; };
+
+            // Feeds nodes and edges to the builder used to construct a 'memgraph' (throws std::runtime_error
+            //  if an entry is corrupt; nothing is fed then).
+            void load_into(graph_data_file_builder& builder) const;
+            // Builds the 'memgraph' of the snapshot. The graph of the library owns its nodes and
+            //  edges, so that copy can't be avoided, but the builder only lives while it is built.
+            std::unique_ptr<memgraph> make_graph() const;
+            // Number of nodes whose outgoing edges (end and length) differ in 'graph'.
+            std::size_t check(graph& graph) const;
+
+            // Returns true if 'filename' starts with the snapshot magic.
+            static bool is_snapshot(const std::string& filename);
+            // ... and has the version of this build.
+            static bool is_current(const std::string& filename);
+
+            // Converts a text dataset (one edge per line: 'init end [length]',
+            // '#' or '%' comment lines) into a snapshot file.
+            static void convert(const std::string& text_file, const std::string& snapshot_file);
+
+            // Returns the path of a snapshot for 'dataset': the dataset itself if
+            // it already is one, otherwise '<dataset>.snapshot', converting the
+            // text file only when the snapshot is missing, older than it or of
+            // another version.
+            static std::string ensure(const std::string& dataset);
+
+        private:
+            graph_snapshot(const graph_snapshot&);
+            void validate() const;
+            graph_snapshot& operator=(const graph_snapshot&);
+
+            void* _data;
+            std::size_t _size;
+            #ifdef _WINDOWS
+                void* _file;
+                void* _mapping;
+            #endif
+
+            const header* _header;
+            const std::uint64_t* _offsets;
+            const std::uint32_t* _targets;
+            const float* _lengths;
+            const std::uint64_t* _id_offsets;
+            const std::uint32_t* _id_order;
+            const char* _id_chars;
+        };
+
+    // Accumulates nodes and edges and writes them in snapshot format.
+    class graph_snapshot_writer {
+        public:
+            graph_snapshot::_t_index add_node(const graph::_t_node_id& id);
+            void add_edge(const graph::_t_node_id& init, const graph::_t_node_id& end, float length);
+
+            // Writes a temporary file next to 'filename' and renames it over it (readers never map a partial file).
+            void write(const std::string& filename) const;
+
+        protected:
+            std::unordered_map<graph::_t_node_id, graph_snapshot::_t_index> index;
+            std::vector<graph::_t_node_id> ids;
+            std::vector<std::pair<graph_snapshot::_t_index, std::pair<graph_snapshot::_t_index, float>>> edges;
+        };
+
+    }
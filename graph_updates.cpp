@@ -0,0 +1,121 @@
+
+#include "graph_updates.h"
+
+#include <set>
+#include <sstream>
+#include <memory>
+#include <algorithm>
+#include <unordered_set>
+
+#include "jgsogo/AnCO/algorithm/aco_base.h"
+#include "graph_index.h"
+#include "lazy_evaporation.h"
+#include "pheromone_scan.h"
+
+namespace AnCO {
+
+    namespace {
+        // Edges leaving 'node': the ones of the library graph and the ones inserted into 'index'
+        void out_edges(graph& graph, const graph_index* index, const graph::_t_node_id& node, std::vector<edge_ptr>& out) {
+            const std::set<graph::_t_node_id> none;
+            out.clear();
+            algorithm::aco_base::get_feasible_edges(graph, node, out, none);
+            const graph_index::_t_index i = index ? index->node(node) : graph_index::npos;
+            if (i != graph_index::npos) {
+                const std::vector<graph_index::_t_index>& inserted = index->inserted_out(i);
+                for (auto it = inserted.begin(); it != inserted.end(); ++it) {
+                    out.push_back(index->get_edges()[*it]);
+                    }
+                }
+            }
+        }
+
+    void graph_updates::set_length(const graph::_t_node_id& init, const graph::_t_node_id& end, float length) {
+        change c = {init, end, length, false};
+        changes.push_back(c);
+        }
+
+    void graph_updates::remove(const graph::_t_node_id& init, const graph::_t_node_id& end) {
+        change c = {init, end, (std::numeric_limits<float>::infinity)(), false};
+        changes.push_back(c);
+        }
+
+    void graph_updates::insert(const graph::_t_node_id& init, const graph::_t_node_id& end, float length) {
+        change c = {init, end, length, true};
+        changes.push_back(c);
+        }
+
+    bool graph_updates::parse(const std::string& line) {
+        std::istringstream is(line);
+        std::string op;
+        graph::_t_node_id init, end;
+        float length = 0.f;
+        if (!(is >> op >> init >> end)) {
+            return false;
+            }
+        if (op == "remove") {
+            this->remove(init, end);
+            return true;
+            }
+        if ((op == "length" || op == "insert") && (is >> length) && length >= 0.f) {
+            if (op == "insert") {
+                this->insert(init, end, length);
+                }
+            else {
+                this->set_length(init, end, length);
+                }
+            return true;
+            }
+        return false;
+        }
+
+    std::size_t graph_updates::apply(graph& graph, graph_index* index, lazy_evaporation* evaporation) const {
+        std::vector<edge_ptr> out;
+        std::unordered_set<const edge_ptr::element_type*> changed;
+        std::unordered_set<graph::_t_node_id> ends;
+        for (auto c = changes.begin(); c != changes.end(); ++c) {
+            out_edges(graph, index, c->init, out);
+            bool found = false;
+            for (auto it = out.begin(); it != out.end(); ++it) {
+                if ((*it)->end != c->end) {
+                    continue;
+                    }
+                found = true;
+                if (evaporation) {
+                    evaporation->touch(it->get()); // pending decay first: the scaling below is on current values
+                    }
+                (*it)->data.length = c->length;
+                algorithm::pheromone_row_scale((*it)->data.pheromone, N_MAX_COLONIES, edge_removed(**it) ? 0.f : decay);
+                changed.insert(it->get());
+                ends.insert(c->end);
+                }
+            if (!found && c->insert && index) {
+                edge_ptr e = std::make_shared<edge_ptr::element_type>();
+                e->init = c->init;
+                e->end = c->end;
+                e->data.length = c->length;
+                std::fill_n(e->data.pheromone, N_MAX_COLONIES, 0.f);
+                if (index->insert(e) != graph_index::npos) {
+                    changed.insert(e.get());
+                    ends.insert(c->end);
+                    }
+                }
+            }
+
+        // Paths that went through the changed edges lose part of their support
+        for (auto n = ends.begin(); n != ends.end(); ++n) {
+            out_edges(graph, index, *n, out);
+            for (auto it = out.begin(); it != out.end(); ++it) {
+                if (changed.count(it->get())) {
+                    continue;
+                    }
+                if (evaporation) {
+                    evaporation->touch(it->get());
+                    }
+                algorithm::pheromone_row_scale((*it)->data.pheromone, N_MAX_COLONIES, neighbour_decay);
+                }
+            }
+        return changed.size();
+        }
+
+    }
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <limits>
+
+#include "jgsogo/AnCO/graph/graph.h"
+
+namespace AnCO {
+
+    class lazy_evaporation;
+    class graph_index;
+
+    /*
+    A batch of changes to the live graph: new lengths, removed edges and
+    inserted edges. The graph of the library has no way to add or drop
+    edges once built, so:
+        - a removed edge stays where it is with an infinite length (see
+          'edge_removed') and no pheromone; ants of this block (those of
+          the neighbourhood included, see 'aco_random_streams') and
+          'corridor_path' never take it,
+        - inserting an edge that exists (removed or not) sets its length,
+        - a new edge is created here and added to the 'graph_index' of the
+          graph (both nodes must be in it). Every ant that walks with the
+          index installed ('graph_index::scope': the neighbourhood, the
+          search colonies) and 'corridor_path' take it like any other;
+          'search_pipeline::evaporate' decays it with the rest. Only the
+          metasearch (over the meta-graph) and the proximity of the
+          colonies, both inside the library, don't see it. Inserted edges
+          are not part of the snapshot, nor of checkpoints.
+
+    The batch is applied between iterations with the pipeline mutex held
+    ('search_pipeline::apply_updates'): every ant runs inside a locked
+    iteration, so none is walking while edges change, and no edge is ever
+    freed (an 'edge_ptr' taken by an ant stays valid).
+
+    Instead of retraining, the pheromone is decayed locally: every slot of a
+    changed edge is scaled by 'decay' (0 forgets it) and the edges leaving
+    its end node by 'neighbour_decay' (paths through it lose their support),
+    so the colonies look for alternatives in a few iterations.
+
+    Text format (one change per line, as in the query stream of 'query_server'):
+        length <init> <end> <length>
+        remove <init> <end>
+        insert <init> <end> <length>
+    */
+    class graph_updates {
+        public:
+            graph_updates(float decay = 0.f, float neighbour_decay = 0.5f) : decay(decay), neighbour_decay(neighbour_decay) {};
+
+            void set_length(const graph::_t_node_id& init, const graph::_t_node_id& end, float length);
+            void remove(const graph::_t_node_id& init, const graph::_t_node_id& end);
+            void insert(const graph::_t_node_id& init, const graph::_t_node_id& end, float length);
+            bool parse(const std::string& line);
+
+            std::size_t size() const { return changes.size(); };
+            void clear() { changes.clear(); };
+
+            // Applies the batch (caller holds the pipeline mutex); returns the number of edges changed or
+            //  inserted. Without 'index' (or for nodes that are not in it) new edges are dropped, as are
+            //  changes to edges that are not in the graph.
+            std::size_t apply(graph& graph, graph_index* index = nullptr, lazy_evaporation* evaporation = nullptr) const;
+
+        protected:
+            struct change {
+                graph::_t_node_id init, end;
+                float length; // infinity for 'remove'
+                bool insert;  // create the edge if it is not there
+                };
+
+            float decay, neighbour_decay;
+            std::vector<change> changes;
+        };
+
+    inline bool edge_removed(const edge_ptr::element_type& e) {
+        return e.data.length == (std::numeric_limits<float>::infinity)();
+        }
+
+    }
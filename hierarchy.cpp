@@ -0,0 +1,221 @@
+
+#include "hierarchy.h"
+
+#include <set>
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+#include "corridor_path.h"
+#include "pheromone_scan.h"
+#include "parallel_run.h"
+
+namespace AnCO {
+
+    namespace {
+        // Dijkstra over the (small) meta-graph of the top level
+        bool shortest_route(const meta_graph_maintainer::snapshot& meta, std::uint32_t from, std::uint32_t to, std::vector<std::uint32_t>& route) {
+            typedef std::pair<float, std::uint32_t> _t_item;
+            const std::size_t n = meta.nodes.size();
+            std::vector<float> distance(n, (std::numeric_limits<float>::max)());
+            std::vector<std::uint32_t> parent(n, std::uint32_t(n));
+            std::priority_queue<_t_item, std::vector<_t_item>, std::greater<_t_item>> queue;
+            distance[from] = 0.f;
+            queue.push(std::make_pair(0.f, from));
+            while (!queue.empty()) {
+                const _t_item item = queue.top();
+                queue.pop();
+                if (item.first > distance[item.second]) {
+                    continue;
+                    }
+                if (item.second == to) {
+                    break;
+                    }
+                if (item.second >= meta.rows.size()) {
+                    continue;
+                    }
+                const std::vector<meta_graph_maintainer::edge>& out = *meta.rows[item.second];
+                for (auto it = out.begin(); it != out.end(); ++it) {
+                    const float d = item.first + it->cost;
+                    if (d < distance[it->to]) {
+                        distance[it->to] = d;
+                        parent[it->to] = item.second;
+                        queue.push(std::make_pair(d, it->to));
+                        }
+                    }
+                }
+            route.clear();
+            if (distance[to] == (std::numeric_limits<float>::max)()) {
+                return false;
+                }
+            for (std::uint32_t v = to; v != from; v = parent[v]) {
+                route.push_back(v);
+                }
+            route.push_back(from);
+            std::reverse(route.begin(), route.end());
+            return true;
+            }
+
+        std::uint32_t index_of(const meta_graph_maintainer::snapshot& meta, const graph::_t_node_id& node) {
+            return std::uint32_t(std::find(meta.nodes.begin(), meta.nodes.end(), node) - meta.nodes.begin());
+            }
+        }
+
+    search_hierarchy::level::level(const meta_graph_maintainer::snapshot& lower, std::size_t n_colonies, const config& cfg) {
+        for (auto it = lower.nodes.begin(); it != lower.nodes.end(); ++it) {
+            dataset.add_node(*it);
+            }
+        for (auto row = lower.rows.begin(); row != lower.rows.end(); ++row) {
+            for (auto it = (*row)->begin(); it != (*row)->end(); ++it) {
+                dataset.add_edge(lower.nodes[it->from], lower.nodes[it->to], it->cost);
+                }
+            }
+        level_graph.reset(new memgraph(dataset));
+        colonies.reset(new neighbourhood_type(*level_graph, (unsigned int)n_colonies, cfg.n_ants_per_colony, cfg.max_steps));
+        auto all = colonies->get_colonies();
+        for (auto c = all.begin(); c != all.end(); ++c) {
+            check_colony_id((*c)->get_id());
+            }
+        }
+
+    graph::_t_node_id search_hierarchy::level::anchor(const graph::_t_node_id& node) {
+        const std::set<graph::_t_node_id> none;
+        std::vector<edge_ptr> out;
+        algorithm::aco_base::get_feasible_edges(*level_graph, node, out, none);
+        auto all = colonies->get_colonies();
+        graph::_t_node_id best;
+        float best_value = -1.f;
+        for (auto c = all.begin(); c != all.end(); ++c) {
+            if ((*c)->get_base_node() == node) {
+                return node;
+                }
+            float value = 0.f;
+            for (auto e = out.begin(); e != out.end(); ++e) {
+                value += (*e)->data.pheromone[(*c)->get_id()];
+                }
+            if (value > best_value) {
+                best_value = value;
+                best = (*c)->get_base_node();
+                }
+            }
+        return best;
+        }
+
+    std::vector<unsigned int> search_hierarchy::level::colony_ids(const std::vector<graph::_t_node_id>& nodes) {
+        auto all = colonies->get_colonies();
+        std::vector<unsigned int> ids;
+        for (auto n = nodes.begin(); n != nodes.end(); ++n) {
+            for (auto c = all.begin(); c != all.end(); ++c) {
+                if ((*c)->get_base_node() == *n) {
+                    ids.push_back((*c)->get_id());
+                    }
+                }
+            }
+        return ids;
+        }
+
+    search_hierarchy::search_hierarchy(search_pipeline& pipeline, std::size_t branching, std::size_t max_levels)
+        : pipeline(pipeline), branching((std::max)(std::size_t(2), branching)), max_levels(max_levels), is_stale(false), stale_since(0) {
+        }
+
+    void search_hierarchy::build(unsigned int iterations) {
+        // The levels train on the pool of the pipeline: no iteration of it may run meanwhile
+        std::lock_guard<std::mutex> lock(pipeline.get_mutex());
+        const config& cfg = pipeline.get_config();
+        levels.clear();
+        is_stale = false; // an 'invalidate' from now on is for this build
+        meta_graph_maintainer::_t_ptr lower = pipeline.get_meta_graph().get();
+        while (levels.size() < max_levels && lower->nodes.size() > branching) {
+            std::unique_ptr<level> l(new level(*lower, (std::max)(std::size_t(2), lower->nodes.size()/branching), cfg));
+            convergence_monitor monitor(pipeline.get_convergence());
+            for (unsigned int iteration = 0; iteration < iterations; ++iteration) {
+                parallel_run(pipeline.get_pool()).add(*l->colonies).run();
+                l->colonies->update();
+                colony_type::aco_algorithm_impl::update_graph(*l->level_graph);
+                if (monitor.add(double(l->meta_graph.update(*l->colonies)))) {
+                    break;
+                    }
+                }
+            l->meta_graph.flush();
+            lower = l->meta_graph.get();
+            levels.push_back(std::move(l));
+            }
+        }
+
+    void search_hierarchy::invalidate() {
+        stale_since = pipeline.get_iteration();
+        is_stale = true;
+        }
+
+    bool search_hierarchy::refresh(unsigned int iterations) {
+        if (!is_stale) {
+            return false;
+            }
+        {
+            std::lock_guard<std::mutex> lock(pipeline.get_mutex());
+            if (!pipeline.converged() && pipeline.get_iteration() < stale_since + iterations) {
+                return false;
+                }
+        }
+        this->build(iterations);
+        return true;
+        }
+
+    bool search_hierarchy::descend(const graph::_t_node_id& from, const graph::_t_node_id& to,
+                                   std::vector<graph::_t_node_id>& route, std::vector<float>& costs) {
+        route.clear();
+        costs.clear();
+        if (levels.empty() || is_stale) {
+            return false;
+            }
+
+        // Anchors of 'from' and 'to' at every level (level 0: themselves)
+        std::vector<graph::_t_node_id> from_at(1, from), to_at(1, to);
+        for (std::size_t l = 1; l <= levels.size(); ++l) {
+            from_at.push_back(this->get_level(l).anchor(from_at.back()));
+            to_at.push_back(this->get_level(l).anchor(to_at.back()));
+            }
+
+        // Top level: shortest route in its meta-graph
+        meta_graph_maintainer::_t_ptr top = levels.back()->meta_graph.get();
+        std::vector<std::uint32_t> top_route;
+        const std::uint32_t top_from = index_of(*top, from_at.back()), top_to = index_of(*top, to_at.back());
+        if (top_from >= top->nodes.size() || top_to >= top->nodes.size() || !shortest_route(*top, top_from, top_to, top_route)) {
+            return false;
+            }
+        for (auto it = top_route.begin(); it != top_route.end(); ++it) {
+            route.push_back(top->nodes[*it]);
+            }
+
+        // Down: the colonies of the route are the corridor of the level below
+        std::vector<edge_ptr> path;
+        for (std::size_t l = levels.size(); l >= 1; --l) {
+            level& current = this->get_level(l);
+            const std::vector<unsigned int> ids = current.colony_ids(route);
+            if (!algorithm::corridor_path(*current.level_graph, from_at[l-1], to_at[l-1], ids, algorithm::pheromone_threshold, path)) {
+                route.clear();
+                return false; // the query falls back to the flat meta-graph
+                }
+            route.assign(1, from_at[l-1]);
+            costs.clear();
+            for (auto it = path.begin(); it != path.end(); ++it) {
+                route.push_back((*it)->end);
+                costs.push_back((*it)->data.length);
+                }
+            }
+        return true;
+        }
+
+    std::size_t search_hierarchy::colonies_above(std::size_t n_colonies, std::size_t branching, std::size_t max_levels) {
+        branching = (std::max)(std::size_t(2), branching);
+        std::size_t total = 0;
+        for (std::size_t l = 0; l < max_levels && n_colonies > branching; ++l) {
+            n_colonies = (std::max)(std::size_t(2), n_colonies/branching);
+            total += n_colonies;
+            }
+        return total;
+        }
+
+    }
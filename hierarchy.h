@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+
+#include "search_pipeline.h"
+
+namespace AnCO {
+
+    /*
+    Levels of colonies above the neighbourhood of the pipeline. Level 'l+1'
+    is a neighbourhood of 'n_l / branching' colonies trained over the
+    meta-graph of level 'l' (a 'memgraph' whose nodes are the base nodes of
+    the colonies of level 'l'); levels are added until one has no more than
+    'branching' colonies (or there are 'max_levels'). Level 0 is the
+    pipeline itself.
+
+    A query descends from the top: the shortest route between the colonies
+    that anchor its start/end at the top meta-graph, then, level by level,
+    the shortest path inside the corridor of the colonies of the route above
+    (see 'corridor_path'). The result is a route through the colonies of the
+    pipeline, so the search in the original graph is the same as with the
+    flat meta-graph, but no level is searched over more than a few colonies.
+    If a corridor has no path, 'descend' fails and the query searches the
+    flat meta-graph instead.
+
+    Levels are built once the pipeline is trained ('build') and don't train
+    afterwards. Changes to the graph and a restored checkpoint make them
+    stale ('invalidate'): 'descend' fails until 'refresh' builds them again,
+    once the pipeline has trained on the new state.
+    */
+    class search_hierarchy {
+        public:
+            struct level {
+                level(const meta_graph_maintainer::snapshot& lower, std::size_t n_colonies, const config& cfg);
+
+                // Colony of this level with the most pheromone around 'node' (a node of 'level_graph'); returns its base node
+                graph::_t_node_id anchor(const graph::_t_node_id& node);
+                // Pheromone ids of the colonies based at 'nodes'
+                std::vector<unsigned int> colony_ids(const std::vector<graph::_t_node_id>& nodes);
+
+                graph_data_file_builder dataset;
+                std::unique_ptr<memgraph> level_graph;
+                std::unique_ptr<neighbourhood_type> colonies;
+                meta_graph_maintainer meta_graph;
+                };
+
+            search_hierarchy(search_pipeline& pipeline, std::size_t branching = 8, std::size_t max_levels = 4);
+
+            // Builds (and trains for up to 'iterations' each) the levels above the pipeline. Holds the mutex of
+            //  the pipeline meanwhile (its pool is not reentrant): the caller must not hold it.
+            void build(unsigned int iterations);
+            // The levels no longer match the pipeline (called by 'search_pipeline::apply_updates' and 'checkpoint::load').
+            void invalidate();
+            bool stale() const { return is_stale; };
+            // Builds the levels again if they are stale and the pipeline has converged (or trained 'iterations'
+            //  iterations) since; returns true if it did. Nobody may be descending them meanwhile.
+            bool refresh(unsigned int iterations);
+            std::size_t n_levels() const { return levels.size(); };
+            level& get_level(std::size_t l) { return *levels[l-1]; };
+
+            // Route between two colonies of the pipeline (base nodes), descending from the top level; 'costs'
+            // are the ones of the meta-graph of the pipeline for every hop.
+            bool descend(const graph::_t_node_id& from, const graph::_t_node_id& to,
+                         std::vector<graph::_t_node_id>& route, std::vector<float>& costs);
+
+            // Colonies that 'build' adds on top of 'n_colonies' (to size N_MAX_COLONIES).
+            static std::size_t colonies_above(std::size_t n_colonies, std::size_t branching, std::size_t max_levels);
+
+        protected:
+            search_pipeline& pipeline;
+            std::size_t branching;
+            std::size_t max_levels;
+            std::vector<std::unique_ptr<level>> levels;
+            std::atomic<bool> is_stale;
+            std::atomic<unsigned int> stale_since; // iteration of the pipeline
+        };
+
+    }
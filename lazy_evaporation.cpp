@@ -0,0 +1,106 @@
+
+#include "lazy_evaporation.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "pheromone_scan.h"
+
+namespace AnCO {
+
+    namespace {
+        thread_local lazy_evaporation* current_evaporation = nullptr;
+        }
+
+    lazy_evaporation::scope::scope(lazy_evaporation* evaporation) : previous(current_evaporation) {
+        current_evaporation = evaporation;
+        }
+
+    lazy_evaporation::scope::~scope() {
+        current_evaporation = previous;
+        }
+
+    lazy_evaporation* lazy_evaporation::current() {
+        return current_evaporation;
+        }
+
+    lazy_evaporation::lazy_evaporation(const graph_index& index, float rho, std::size_t block_size)
+        : index(index), rho(rho), block_size((std::max)(std::size_t(1), block_size)), locks(64), now(0) {
+        n_covered = index.n_edges();
+        n_blocks = (n_covered + this->block_size - 1)/this->block_size;
+        stamps.reset(new std::atomic<std::uint32_t>[n_blocks]);
+        this->reset();
+        }
+
+    void lazy_evaporation::reset() {
+        for (std::size_t b = 0; b<n_blocks; ++b) {
+            stamps[b].store(now, std::memory_order_relaxed);
+            }
+        }
+
+    void lazy_evaporation::advance() {
+        this->cover();
+        ++now;
+        }
+
+    void lazy_evaporation::cover() {
+        const std::size_t n_edges = index.n_edges();
+        if (n_edges == n_covered) {
+            return;
+            }
+        // New edges of the last block start with nothing pending, as the block once settled
+        if (n_covered % block_size) {
+            this->settle(n_covered/block_size);
+            }
+        const std::size_t blocks = (n_edges + block_size - 1)/block_size;
+        if (blocks > n_blocks) {
+            std::unique_ptr<std::atomic<std::uint32_t>[]> grown(new std::atomic<std::uint32_t>[blocks]);
+            for (std::size_t b = 0; b<blocks; ++b) {
+                grown[b].store((b < n_blocks) ? stamps[b].load(std::memory_order_relaxed) : now, std::memory_order_relaxed);
+                }
+            stamps.swap(grown);
+            n_blocks = blocks;
+            }
+        n_covered = n_edges;
+        }
+
+    void lazy_evaporation::touch(const _t_edge* e) {
+        const graph_index::_t_index i = index.edge(e);
+        if (i < n_covered) {
+            this->settle(i/block_size);
+            }
+        }
+
+    void lazy_evaporation::settle(std::size_t block) {
+        if (stamps[block].load(std::memory_order_acquire) == now) {
+            return;
+            }
+        std::lock_guard<std::mutex> lock(locks[block % locks.size()]);
+        const std::uint32_t stamp = stamps[block].load(std::memory_order_relaxed);
+        if (stamp == now) {
+            return;
+            }
+        const float factor = float(std::pow(1. - rho, double(now - stamp)));
+        const std::vector<edge_ptr>& edges = index.get_edges();
+        const std::size_t end = (std::min)(n_covered, (block+1)*block_size);
+        for (std::size_t e = block*block_size; e<end; ++e) {
+            algorithm::pheromone_row_scale(edges[e]->data.pheromone, N_MAX_COLONIES, factor);
+            }
+        stamps[block].store(now, std::memory_order_release);
+        }
+
+    void lazy_evaporation::compact(work_stealing_pool& pool) {
+        const std::size_t n_tasks = (std::min)(n_blocks, std::size_t(pool.size())*4);
+        std::vector<work_stealing_pool::_t_task> tasks;
+        for (std::size_t t = 0; t<n_tasks; ++t) {
+            const std::size_t begin = (n_blocks*t)/n_tasks, end = (n_blocks*(t+1))/n_tasks;
+            tasks.push_back([this, begin, end](){
+                for (std::size_t b = begin; b<end; ++b) {
+                    this->settle(b);
+                    }
+                });
+            }
+        pool.run(tasks);
+        }
+
+    }
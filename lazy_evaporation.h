@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+#include "jgsogo/AnCO/graph/graph.h"
+#include "graph_index.h"
+#include "work_stealing_pool.h"
+#include "counter_rng.h"
+
+namespace AnCO {
+
+    /*
+    Evaporation of the pheromone of the graph without touching every edge
+    every iteration: 'advance' only moves the clock, and each block of
+    'block_size' edges (snapshot order of the 'graph_index') remembers the
+    iteration it was last evaporated at. The accumulated decay
+    '(1-rho)^(now-stamp)' is applied in one go when the block is touched
+    ('touch') or for every block with 'compact' (parallel over the pool,
+    vectorized per edge).
+
+    Edges are touched before every deposit (colonies whose algorithm is a
+    'settle_before_deposit') and before the reads of this block (ants of
+    'aco_multiobjetivo', also before its MMAS fallback, 'corridor_path',
+    'graph_updates', checkpoints), so every deposit lands on a settled
+    value. The library reads the pheromone of the whole graph for the
+    proximity of the colonies: 'search_pipeline::update_meta_graph'
+    compacts right before (in parallel, and only when the matrix is read);
+    the walks of the neighbourhood ('aco_random_streams') don't read it.
+    'rho' is a rate of its own: the library doesn't expose the one of
+    'update_graph', which this replaces. Edges inserted into the index
+    ('graph_updates') get blocks at the next 'advance' ('cover'); until
+    then they have no decay pending.
+    */
+    class lazy_evaporation {
+        public:
+            typedef edge_ptr::element_type _t_edge;
+
+            lazy_evaporation(const graph_index& index, float rho, std::size_t block_size = 64);
+
+            // End of an iteration (instead of 'update_graph'): O(1), plus the blocks of the edges inserted since.
+            void advance();
+            // Applies the pending decay of the block of 'e' (thread-safe, before reading its pheromone).
+            void touch(const _t_edge* e);
+            // Applies the pending decay of every block.
+            void compact(work_stealing_pool& pool);
+            // The pheromone has been overwritten (checkpoint restore): nothing is pending.
+            void reset();
+
+            std::uint32_t get_time() const { return now; };
+            std::size_t n_edges() const { return index.n_edges(); };
+
+            // Instance used by 'aco_multiobjetivo' in this thread (like 'objective_scope').
+            class scope {
+                public:
+                    scope(lazy_evaporation* evaporation);
+                    ~scope();
+                private:
+                    scope(const scope&);
+                    scope& operator=(const scope&);
+                    lazy_evaporation* previous;
+                };
+            static lazy_evaporation* current();
+
+        protected:
+            void settle(std::size_t block);
+            // Blocks for the edges inserted into the index (caller holds the pipeline mutex: no ant is walking).
+            void cover();
+
+            const graph_index& index;
+            float rho;
+            std::size_t block_size;
+
+            std::size_t n_covered; // edges of the index with a block
+            std::size_t n_blocks;
+            std::unique_ptr<std::atomic<std::uint32_t>[]> stamps;
+            std::vector<std::mutex> locks;  // striped over the blocks
+            std::uint32_t now;
+        };
+
+    /*
+    ACO algorithm 'algorithm_t' whose colonies settle the pending evaporation
+    of the edges they deposit on: the colony calls 'select_paths' in its
+    'update', right before depositing on the paths it keeps. It needs the
+    'lazy_evaporation::scope' of the thread that calls 'update'.
+    */
+    template <class algorithm_t>
+    struct settle_before_deposit : public algorithm_t {
+        static void select_paths(std::vector<std::pair<typename algorithm_t::_t_ant_path, bool>>& tmp_paths) {
+            algorithm_t::select_paths(tmp_paths);
+            if (lazy_evaporation* evaporation = lazy_evaporation::current()) {
+                for (auto path = tmp_paths.begin(); path != tmp_paths.end(); ++path) {
+                    for (auto it = path->first.begin(); it != path->first.end(); ++it) {
+                        evaporation->touch(it->get());
+                        }
+                    }
+                }
+            };
+        };
+
+    template <class algorithm_t>
+    struct draws_from_streams<settle_before_deposit<algorithm_t>> : public draws_from_streams<algorithm_t> {
+        };
+
+    }
@@ -11,6 +11,10 @@
 #include <iterator>
 #include <iomanip>
 #include <numeric>
+#include <fstream>
+#include <cstring>
+#include <limits>
+#include <memory>
 
 #include "jgsogo/AnCO/config.h"
 
@@ -32,6 +36,14 @@
 
 #include "success_meta.h"
 #include "aco_multiobjetivo.h"
+#include "graph_snapshot.h"
+#include "search_pipeline.h"
+#include "query_server.h"
+#include "checkpoint.h"
+#include "pipeline_metrics.h"
+#include "lazy_evaporation.h"
+#include "counter_rng.h"
+#include "hierarchy.h"
 
 #ifdef _WINDOWS
 
@@ -45,25 +57,131 @@
 
 using namespace AnCO;
 
-typedef algorithm::prox_percent prox_algorithm;
-typedef algorithm::aco_random aco_algorithm;
-
-typedef AnCO::colony<algorithm::aco_base> colony_type;
-
-typedef AnCO::colony_neighbourhood<aco_algorithm, prox_algorithm> colony_neighbourhood_type;
-typedef AnCO::neighbourhood<aco_algorithm, prox_algorithm> neighbourhood_type;
-
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) { // Check the number of parameters
+    // Options: '--serve' answers a stream of '<start> <end>' queries from stdin ('--queries FILE' reads them from a file);
+    //              lines '!length|remove|insert <init> <end> [<length>]' in the stream change the graph (see 'graph_updates')
+    //          '--checkpoint FILE' restores the training state at startup and saves it every '--checkpoint-every N' iterations
+    //              (captured a slice per iteration over those N, so no iteration copies the whole graph)
+    //          '--headless' never waits for the user nor clears/prints the console; metrics are written as JSON lines
+    //              to stdout (stderr when serving, or '--metrics FILE') every '--metrics-every N' training iterations
+    //              and after every step
+    //          '--refine' takes the shortest path inside the corridor of the meta-path before searching with ants
+    //          '--evaporation-rate R' evaporates lazily with a rate R of its own (instead of 'update_graph' over every
+    //              edge): each edge decays when it is next read or deposited on (see 'lazy_evaporation')
+    //          '--converge-window N' stops every training loop/search once its signals have been stable (within
+    //              '--converge-tolerance T', relative) for N iterations; the iteration counts remain as a cap
+    //          '--seed N' seeds the counter-based streams: the start/end nodes and the walks of the neighbourhood
+    //              are the same with any number of threads (the search colonies and the metasearch still draw
+    //              from the generator of the library)
+    //          '--levels N' builds up to N levels of colonies above the neighbourhood (each one over the meta-graph
+    //              of the one below, with '--branching B' times fewer colonies); queries descend them
+    //          '--portfolio N' races the N best meta-paths in the original graph (phases 7-8, and every query with
+    //              '--serve'), cancelling the rest as soon as one finds a path with 'cost <= --portfolio-bound C'
+    //              (the first path found by default)
+    bool serve = false;
+    bool headless = false;
+    bool refine = false;
+    std::string queries_file;
+    std::string checkpoint_file;
+    std::string metrics_file;
+    unsigned int checkpoint_every = 10;
+    unsigned int metrics_every = 1;
+    float evaporation_rate = 0.f;
+    convergence_monitor::options convergence;
+    std::size_t portfolio = 1;
+    std::uint64_t seed = 0;
+    std::size_t levels = 0;
+    std::size_t branching = 8;
+    float portfolio_bound = (std::numeric_limits<float>::max)();
+    std::vector<std::string> args;
+    for (int i = 1; i<argc; ++i) {
+        if (std::strcmp(argv[i], "--serve") == 0) {
+            serve = true;
+            }
+        else if (std::strcmp(argv[i], "--queries") == 0 && i+1<argc) {
+            serve = true;
+            queries_file = argv[++i];
+            }
+        else if (std::strcmp(argv[i], "--checkpoint") == 0 && i+1<argc) {
+            checkpoint_file = argv[++i];
+            }
+        else if (std::strcmp(argv[i], "--checkpoint-every") == 0 && i+1<argc) {
+            checkpoint_every = (std::max)(1, std::atoi(argv[++i]));
+            }
+        else if (std::strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+            }
+        else if (std::strcmp(argv[i], "--refine") == 0) {
+            refine = true;
+            }
+        else if (std::strcmp(argv[i], "--metrics") == 0 && i+1<argc) {
+            metrics_file = argv[++i];
+            }
+        else if (std::strcmp(argv[i], "--metrics-every") == 0 && i+1<argc) {
+            metrics_every = (std::max)(1, std::atoi(argv[++i]));
+            }
+        else if (std::strcmp(argv[i], "--evaporation-rate") == 0 && i+1<argc) {
+            evaporation_rate = float(std::atof(argv[++i]));
+            }
+        else if (std::strcmp(argv[i], "--converge-window") == 0 && i+1<argc) {
+            convergence.window = std::size_t((std::max)(0, std::atoi(argv[++i])));
+            }
+        else if (std::strcmp(argv[i], "--converge-tolerance") == 0 && i+1<argc) {
+            convergence.tolerance = std::atof(argv[++i]);
+            }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i+1<argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+            }
+        else if (std::strcmp(argv[i], "--levels") == 0 && i+1<argc) {
+            levels = std::size_t((std::max)(0, std::atoi(argv[++i])));
+            }
+        else if (std::strcmp(argv[i], "--branching") == 0 && i+1<argc) {
+            branching = std::size_t((std::max)(2, std::atoi(argv[++i])));
+            }
+        else if (std::strcmp(argv[i], "--portfolio") == 0 && i+1<argc) {
+            portfolio = std::size_t((std::max)(1, std::atoi(argv[++i])));
+            }
+        else if (std::strcmp(argv[i], "--portfolio-bound") == 0 && i+1<argc) {
+            portfolio_bound = float(std::atof(argv[++i]));
+            }
+        else {
+            args.push_back(argv[i]);
+            }
+        }
+
+    if (args.size() < 1) { // Check the number of parameters
         // Tell the user how to run the program
-        std::cerr << "Usage: " << argv[0] << " 'CONFIG_FILE' ['GRAPH_DATASET']" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " 'CONFIG_FILE' ['GRAPH_DATASET'] [--serve] [--queries 'QUERIES_FILE'] [--checkpoint 'FILE' [--checkpoint-every N]] [--headless] [--refine] [--metrics 'FILE' [--metrics-every N]] [--evaporation-rate R] [--converge-window N [--converge-tolerance T]] [--portfolio N [--portfolio-bound C]] [--seed N] [--levels N [--branching B]]" << std::endl;
         return 1;
         }
-    config cfg = load_config(argv[1]);
-    if (argc>2) {
-        cfg.dataset = argv[2];
+    config cfg = load_config(args[0]);
+    if (args.size()>1) {
+        cfg.dataset = args[1];
         }
+    const std::size_t n_colonies = cfg.n_colonies + search_hierarchy::colonies_above(cfg.n_colonies, branching, levels);
+    // Start, end and search colonies of a query on top: enough only if the library reuses the ids of the
+    //  colonies it destroys. Every colony is checked when it is built ('check_colony_id'), this just fails early.
+    if (n_colonies + 2 + portfolio > N_MAX_COLONIES) {
+        std::cerr << "'" << n_colonies << "' colonies need a build with N_MAX_COLONIES >= " << n_colonies + 2 + portfolio
+                  << " (cmake -DANCO_N_MAX_COLONIES=...)" << std::endl;
+        return 1;
+        }
+
+    // Headless: the narrative goes nowhere, metrics are the output
+    //  (serving: the answers are the output, the narrative goes to stderr)
+    std::ostream null_out(nullptr);
+    std::ostream& out = headless ? null_out : (serve ? std::clog : std::cout);
+    algorithm::aco_multiobjetivo::set_trace(headless ? nullptr : &out); // paths found by the ants go with the narrative
+    std::ofstream metrics_stream;
+    if (!metrics_file.empty()) {
+        metrics_stream.open(metrics_file.c_str());
+        if (!metrics_stream) {
+            std::cerr << "Cannot write '" << metrics_file << "'" << std::endl;
+            return 1;
+            }
+        }
+    std::ostream* metrics_out = !metrics_file.empty() ? static_cast<std::ostream*>(&metrics_stream) : (headless ? (serve ? &std::clog : &std::cout) : nullptr);
 
     #ifdef _WINDOWS
         HWND console = GetConsoleWindow();
@@ -72,274 +190,288 @@ int main(int argc, char* argv[]) {
         MoveWindow(console, r.left, r.top, 1500, 800, TRUE); // 800 width, 100 height
     #endif
 
-    std::cout << "======" << std::endl;
-    std::cout << "AnCO\n";
-    std::cout << "======" << std::endl << std::endl;
+    out << "======" << std::endl;
+    out << "AnCO\n";
+    out << "======" << std::endl << std::endl;
 
-    std::cout << "1) Graph dataset from file" << std::endl;
-    graph_data_file dataset(cfg.dataset);
+    out << "1) Graph dataset from file (binary snapshot)" << std::endl;
+    graph_snapshot snapshot;
     log_time t;
-    dataset.load_file();
-    t.toc();    
+    try {
+        snapshot.open(graph_snapshot::ensure(cfg.dataset));
+        }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+        }
+    t.toc();
+    out << "\t " << snapshot.n_nodes() << " nodes, " << snapshot.n_edges() << " edges" << std::endl;
 
-    std::cout << std::endl << "2) Make graph available on memory" << std::endl;
+    out << std::endl << "2) Make graph available on memory" << std::endl;
     t.tic();
-    AnCO::memgraph graph(dataset);
+    std::unique_ptr<AnCO::memgraph> graph_ptr = snapshot.make_graph();
+    AnCO::memgraph& graph = *graph_ptr;
     t.toc();
 
-    std::cout << std::endl << "3) Create neighbourhood of '" << cfg.n_colonies << "' colonies (aco_random)" << std::endl;
-    neighbourhood_type colony_meta(graph, cfg.n_colonies, cfg.n_ants_per_colony, cfg.max_steps);
+    graph_index index(snapshot, graph);
+    work_stealing_pool pool;
 
-    std::cout << std::endl << "4) Train for " << cfg.training_iterations << " iterations" << std::endl;
-    std::cout << std::endl << "... press INTRO to continue" << std::endl; getchar();
-    unsigned int colony_meta_iteration = 0;
-    while(colony_meta_iteration < cfg.training_iterations) {
-        colony_meta.run();
-        colony_meta.update();
-        colony_type::aco_algorithm_impl::update_graph(graph);
+    out << std::endl << "3) Create neighbourhood of '" << cfg.n_colonies << "' colonies (aco_random_streams)" << std::endl;
+    search_pipeline pipeline(graph, index, cfg, pool);
+    neighbourhood_type& colony_meta = pipeline.get_neighbourhood();
 
-        if (system("CLS")) system("clear");
-        colony_meta_iteration = colony_meta.get_iteration();            
-        std::cout << "Iteration " << colony_meta_iteration << std::endl;
-        colony_meta.print(std::cout);
-        std::cout << std::flush;
+    std::unique_ptr<lazy_evaporation> evaporation;
+    if (evaporation_rate > 0.f) {
+        evaporation.reset(new lazy_evaporation(index, evaporation_rate));
+        pipeline.set_lazy_evaporation(evaporation.get());
+        out << "\t lazy evaporation: rate " << evaporation_rate << std::endl;
+        }
+    pipeline.set_convergence(convergence);
+    random_streams::seed(seed);
+
+    auto report = [&pipeline, metrics_out](){
+        if (metrics_out) {
+            pipeline.get_metrics().write_json(*metrics_out, pipeline.get_iteration());
+            }
+        };
+
+    std::unique_ptr<checkpoint> ckpt;
+    if (!checkpoint_file.empty()) {
+        ckpt.reset(new checkpoint(checkpoint_file, snapshot, graph, checkpoint_every));
+        if (ckpt->load(pipeline)) {
+            out << "\t restored checkpoint '" << checkpoint_file << "' at iteration " << pipeline.get_iteration() << std::endl;
+            }
+        }
+    checkpoint* c = ckpt.get();
+    pipeline.set_listener([c, checkpoint_every, metrics_out, metrics_every](search_pipeline& p){
+        if (c && (c->capturing() || p.get_iteration() % checkpoint_every == 0)) {
+            c->save(p);
+            }
+        if (metrics_out && p.get_iteration() % metrics_every == 0) {
+            p.get_metrics().write_json(*metrics_out, p.get_iteration());
+            }
+        });
+
+    search_hierarchy hierarchy(pipeline, branching, levels);
+    auto build_levels = [&](){
+        if (levels > 0) {
+            hierarchy.build(cfg.training_iterations);
+            pipeline.set_hierarchy(&hierarchy);
+            out << "\t hierarchy: " << hierarchy.n_levels() << " levels above the neighbourhood" << std::endl;
+            }
+        };
+
+    out << std::endl << "4) Train for " << cfg.training_iterations << " iterations (" << pool.size() << " threads)" << std::endl;
+    if (serve) {
+        while(pipeline.get_iteration() < cfg.training_iterations && !pipeline.converged()) {
+            pipeline.iterate();
+            }
+        build_levels();
+
+        out << std::endl << "5) Serving queries from " << (queries_file.empty() ? std::string("stdin") : queries_file) << std::endl;
+        std::cout << "# start end found metapath_steps path_steps path_cost latency_ms" << std::endl;
+        query_server server(pipeline, snapshot, refine, portfolio, portfolio_bound);
+        server.start_background();
+        if (queries_file.empty()) {
+            server.serve(std::cin, std::cout);
+            }
+        else {
+            std::ifstream queries(queries_file.c_str());
+            if (!queries) {
+                std::cerr << "Cannot open '" << queries_file << "'" << std::endl;
+                return 1;
+                }
+            server.serve(queries, std::cout);
+            }
+        server.stop_background();
+        report();
+        return 0;
+        }
+
+    if (!headless) {
+        out << std::endl << "... press INTRO to continue" << std::endl; getchar();
+        }
+    while(pipeline.get_iteration() < cfg.training_iterations && !pipeline.converged()) {
+        pipeline.iterate();
+
+        if (!headless) {
+            if (system("CLS")) system("clear");
+            out << "Iteration " << pipeline.get_iteration() << std::endl;
+            colony_meta.print(out);
+            out << std::flush;
+            }
         }
          
-    std::cout << "5) Select two random nodes" << std::endl;
-    node_ptr start_node = graph.get_node_random();
-    node_ptr end_node = graph.get_node_random();
-    std::cout << "\t start node: " << start_node->id;
-    std::cout << "\t end node: " << end_node->id;
-
-    colony_neighbourhood_type start_colony(graph, cfg.n_ants_per_colony, cfg.max_steps);
-    start_colony.set_base_node(start_node->id);
-    colony_neighbourhood_type end_colony(graph, cfg.n_ants_per_colony, cfg.max_steps);
-    end_colony.set_base_node(end_node->id);
+    if (pipeline.converged()) {
+        out << "\t converged at iteration " << pipeline.get_iteration() << std::endl;
+        }
+    build_levels();
+    out << "5) Select two random nodes" << std::endl;
+    counter_rng node_rng = random_streams::stream(random_streams::stream_nodes);
+    const graph::_t_node_id start_node = snapshot.node_id(graph_snapshot::_t_index(node_rng.below(std::uint32_t(snapshot.n_nodes()))));
+    const graph::_t_node_id end_node = snapshot.node_id(graph_snapshot::_t_index(node_rng.below(std::uint32_t(snapshot.n_nodes()))));
+    out << "\t start node: " << start_node;
+    out << "\t end node: " << end_node;
+
+    search_query query(pipeline, start_node, end_node);
     unsigned int iterations = 0;
     while (++iterations < cfg.training_iterations) {
-        colony_meta.run();
-        start_colony.run();
-        end_colony.run();
-        colony_meta.update();
-        start_colony.update();
-        end_colony.update();
-        colony_type::aco_algorithm_impl::update_graph(graph);
+        if (query.iterate()) {
+            break;
+            }
+        if (headless) {
+            continue;
+            }
 
         if (system("CLS")) system("clear");
-        colony_meta_iteration = colony_meta.get_iteration();            
-        std::cout << "Iteration " << colony_meta_iteration << std::endl;
+        out << "Iteration " << pipeline.get_iteration() << std::endl;
             
-        colony_meta.print(std::cout);
-        std::cout << std::endl;
-        std::cout << "START COLONY @ node " << start_node->id << std::endl;
-        start_colony.print(std::cout);
-        std::cout << std::endl << std::endl;
-        std::cout << "END COLONY @ node " << end_node->id << std::endl;
-        end_colony.print(std::cout);
-        std::cout << std::endl << std::endl;
+        colony_meta.print(out);
+        out << std::endl;
+        out << "START COLONY @ node " << start_node << std::endl;
+        query.get_start_colony().print(out);
+        out << std::endl << std::endl;
+        out << "END COLONY @ node " << end_node << std::endl;
+        query.get_end_colony().print(out);
+        out << std::endl << std::endl;
             
-        std::cout << std::flush;
+        out << std::flush;
         }
     
-    if (start_colony.get_metric()<=0.f || end_colony.get_metric()<=0.f) {
-        std::cout << " NO path possible (?)!!" << std::endl;
+    report();
+    if (!query.reachable()) {
+        out << " NO path possible (?)!!" << std::endl;
         return 1;
         }
 
-    std::cout << std::endl << "------------------------ begin META-GRAPH ---------------------" << std::endl << std::endl;
-    std::cout << "6) Build meta-graph" << std::endl;
-    std::cout << "\t (meta-graph should we running in background)" << std::endl;
-    AnCO::graph_data_file_builder meta_dataset;
-    // nodos
-    std::cout << "\t - nodes: base node of each colony" << std::endl;
-    meta_dataset.add_node(start_node->id);
-    meta_dataset.add_node(end_node->id);
-    auto colonies = colony_meta.get_colonies();
-    std::for_each(colonies.begin(), colonies.end(), [&meta_dataset](const std::shared_ptr<colony_neighbourhood_type>& item){
-        meta_dataset.add_node(item->get_base_node());
-        });
-
-    // edges
-    std::cout << "\t - edges: neighbourhood with 'probability > 0.f', cost for 'edge = 1-probability'" << std::endl;
-    auto prox_start = start_colony.get_proximity_vector();
-    auto prox_end = end_colony.get_proximity_vector();
-    for (auto i=0; i<colonies.size(); i++) {
-        if (prox_start[i]>0.f) {
-            meta_dataset.add_edge(start_node->id, colonies[i]->get_base_node(), 1-prox_start[i]);
-            std::cout << "\t\t " << start_node->id << " -> " << colonies[i]->get_base_node() << " | cost= '" << 1-prox_start[i] << "'" << std::endl;
-            }
-        if (prox_end[i]>0.f) {
-            meta_dataset.add_edge(colonies[i]->get_base_node(), end_node->id, 1-prox_end[i]);
-            std::cout << "\t\t " << colonies[i]->get_base_node() << " -> " << end_node->id << " | cost= '" << 1-prox_end[i] << "' <-- :S no garantizado!!" << std::endl;
+    out << std::endl << "------------------------ begin META-GRAPH ---------------------" << std::endl << std::endl;
+    bool descended = false;
+    if (hierarchy.n_levels()) {
+        out << "6-7) Meta-path descending " << hierarchy.n_levels() << " levels of colonies (shortest routes in their corridors)" << std::endl;
+        descended = query.descend_meta_path(headless ? nullptr : &std::cout);
+        if (!descended) {
+            out << "\t no route through the levels, searching the flat meta-graph" << std::endl;
             }
         }
-
-    auto matrix = colony_meta.get_proximity_matrix();
-    for (auto i=0; i<colonies.size(); i++) {
-        for (auto j=0; j<colonies.size(); j++) {
-            if ((i!=j) && (matrix[i][j]>0.f)) {
-                meta_dataset.add_edge(colonies[i]->get_base_node(), colonies[j]->get_base_node(), 1 - matrix[i][j]);
-                std::cout << "\t\t " << colonies[i]->get_base_node() << " -> " << colonies[j]->get_base_node() << " | cost= '" << 1 - matrix[i][j] << "'" << std::endl;
-                }
-            }
+    if (!descended) {
+        out << "6) Build meta-graph" << std::endl;
+        out << "\t (meta-graph maintained in background: only start/end nodes are attached)" << std::endl;
+        out << "\t - nodes: base node of each colony" << std::endl;
+        out << "\t - edges: neighbourhood with 'probability > 0.f', cost for 'edge = 1-probability'" << std::endl;
+        query.build_meta_graph(headless ? nullptr : &std::cout);
+
+        out << std::endl << "7) Search for meta-path in meta-graph (MMAS)" << std::endl;
+        query.search_meta_path(cfg.training_iterations);
         }
-    memgraph meta_graph(meta_dataset);
-    
-    std::cout << std::endl << "7) Search for meta-path in meta-graph (MMAS)" << std::endl;
-    AnCO::colony<algorithm::aco_mmas> metasearch_colony(meta_graph, cfg.n_ants_per_colony, cfg.max_steps);
-    metasearch_colony.set_base_node(start_node->id);
-    iterations = 0;
+    report();
+    const success_meta& success = query.get_meta_success();
 
-
-    success_meta success(end_node->id);
-    while (++iterations < cfg.training_iterations) {
-        metasearch_colony.run(success);
-        metasearch_colony.update();
-        colony_type::aco_algorithm_impl::update_graph(meta_graph);        
-        }
-    unsigned int max_length = 0;
-    std::pair<std::vector<edge_ptr>, float> best_metapath = std::make_pair(std::vector<edge_ptr>(), (std::numeric_limits<float>::max)() );
-    if (success.succesful_paths.size()) {
-        std::cout << "\t>>!! THERE IS A PATH ******" << std::endl;
+    unsigned int max_length = query.expected_length();
+    std::pair<std::vector<edge_ptr>, float> best_metapath;
+    if (query.best_meta_path(best_metapath.first, best_metapath.second)) {
+        out << "\t>>!! THERE IS A PATH ******" << std::endl;
         // Select path with
-        std::cout << "\t - candidate meta-paths" << std::endl;
-        std::cout << "\t\t cost | path" << std::endl;
+        out << "\t - candidate meta-paths" << std::endl;
+        out << "\t\t cost | path" << std::endl;
         for (auto it = success.succesful_paths.begin(); it!=success.succesful_paths.end(); ++it) {
-            max_length = (std::max)(int(max_length), int(it->size()*(cfg.max_steps-1)*2)); // las colonias pueden haberse visto justo en sus extremos!
-            float cost = std::accumulate(it->begin(), it->end(), 0.f, [](float x, edge_ptr ptr){ return x + ptr->data.length;});
-            std::cout << "\t\t" << cost << " | " << (*it->begin())->init;
+            out << "\t\t" << search_query::path_cost(*it) << " | " << (*it->begin())->init;
             for (auto jj = it->begin(); jj!=it->end(); ++jj) {
-                std::cout << " -> " << (*jj)->end;
-                }
-            std::cout << std::endl;
-
-            if ((cost < best_metapath.second) || ((cost == best_metapath.second) && (best_metapath.first.size()>it->size()))){
-                best_metapath = std::make_pair( *it, cost );
+                out << " -> " << (*jj)->end;
                 }
+            out << std::endl;
             }
         // y el ltimo path es
-        float cost = std::accumulate(success.tmp.begin(), success.tmp.end(), 0.f, [](float x, edge_ptr ptr){ return x + ptr->data.length;});
-        std::cout << "\t\t" << cost << ".|." << (*success.tmp.begin())->init;
+        out << "\t\t" << search_query::path_cost(success.tmp) << ".|." << (*success.tmp.begin())->init;
         for (auto jj = success.tmp.begin(); jj!=success.tmp.end(); ++jj) {
-            std::cout << " -> " << (*jj)->end;
+            out << " -> " << (*jj)->end;
             }
-        std::cout << std::endl;
+        out << std::endl;
         }
     else {
-        std::cout << "\t>>!! NO PATH FOUND IN META-GRAPH" << std::endl;
+        out << "\t>>!! NO PATH FOUND IN META-GRAPH" << std::endl;
         return 1;
         }
-    std::cout << std::endl << "------------------------ end META-GRAPH ---------------------" << std::endl << std::endl;
-
-    {
-        std::cout << "7) Search for actual path in the ORIGINAL graph (using best meta-path)" << std::endl;
-        std::vector<edge_ptr> metapath = best_metapath.first;
-        std::cout << "\t expected length: 'steps <= " << max_length << "'" << std::endl;
-        std::cout << "\t selected meta-path: " << (*metapath.begin())->init;
-        for (auto it = metapath.begin(); it!= metapath.end(); ++it) {
-            std::cout << " -> " << (*it)->end;
-            }
-        std::cout << std::endl;
-
-        std::cout << std::endl << "... press INTRO to continue" << std::endl; getchar();
-
-        AnCO::colony<algorithm::aco_multiobjetivo> search_colony(graph, cfg.n_ants_per_colony, max_length);
-        search_colony.set_base_node(start_node->id);
-        algorithm::aco_multiobjetivo::objective_list.clear();
-        float objective_price = 1/(float)metapath.size();
-        float sum_price = 0.f;
-        for (auto it = metapath.begin(); it!= metapath.end(); ++it) {
-            sum_price += objective_price;
-            int pherom_id = -1;
-            if ( (*it)->end == end_colony.get_base_node()) {
-                pherom_id = end_colony.get_id();
+    out << std::endl << "------------------------ end META-GRAPH ---------------------" << std::endl << std::endl;
+
+    if (portfolio > 1) {
+        out << "7) Race the best " << portfolio << " meta-paths in the ORIGINAL graph" << std::endl;
+        out << "\t expected length: 'steps <= " << max_length << "'" << std::endl;
+        std::vector<edge_ptr> metapath, path;
+        bool found = query.race_paths(portfolio, cfg.training_iterations+100, portfolio_bound, metapath, path, [&out](){ out << "." << std::flush; });
+        out << std::endl;
+        if (found) {
+            out << "\t winner meta-path: " << (*metapath.begin())->init;
+            for (auto it = metapath.begin(); it!= metapath.end(); ++it) {
+                out << " -> " << (*it)->end;
+                }
+            out << std::endl;
+            out << "\t path found: " << path.size() << " steps, cost= '" << search_query::path_cost(path) << "'" << std::endl;
+            }
+        report();
+        }
+    else {
+        {
+            out << "7) Search for actual path in the ORIGINAL graph (using best meta-path)" << std::endl;
+            const std::vector<edge_ptr>& metapath = best_metapath.first;
+            out << "\t expected length: 'steps <= " << max_length << "'" << std::endl;
+            out << "\t selected meta-path: " << (*metapath.begin())->init;
+            for (auto it = metapath.begin(); it!= metapath.end(); ++it) {
+                out << " -> " << (*it)->end;
+                }
+            out << std::endl;
+
+            std::vector<edge_ptr> path;
+            bool found = refine && query.refine_path(metapath, path);
+            if (found) {
+                out << "\t (shortest path inside the corridor of the meta-path)" << std::endl;
                 }
             else {
-                for (auto c = colonies.begin(); c!=colonies.end(); ++c) {
-                    if ( (*it)->end == (*c)->get_base_node()) {
-                        pherom_id = (*c)->get_id();
-                        }
+                if (!headless) {
+                    out << std::endl << "... press INTRO to continue" << std::endl; getchar();
                     }
+                found = query.search_path(metapath, cfg.training_iterations+100, path, [&out](){ out << "." << std::flush; });
+                out << std::endl;
                 }
-            assert(pherom_id != -1);
-            algorithm::aco_multiobjetivo::objective_list[(*it)->end] = std::make_pair(pherom_id, sum_price);
-            }
-
-        //success_meta success(end_node->id);
-        iterations = 0;
-        success_node_found suc_multiobj(end_node->id);
-        while (++iterations < cfg.training_iterations+100) {
-            std::cout << ".";
-            colony_meta.run();
-            end_colony.run();
-            search_colony.run(suc_multiobj);
-            
-            colony_meta.update();
-            end_colony.update();
-            search_colony.update();
-            
-            colony_type::aco_algorithm_impl::update_graph(graph);        
-            std::cout << std::flush;
-            }
-        std::cout << std::endl;
-    }
+            if (found) {
+                out << "\t path found: " << path.size() << " steps, cost= '" << search_query::path_cost(path) << "'" << std::endl;
+                }
+            report();
+        }
+
 
+        {
+            out << std::endl << "8) Search for actual path in the ORIGINAL graph (using last meta-path)" << std::endl;
+            const std::vector<edge_ptr>& metapath = success.tmp;
+            out << "\t expected length: 'steps <= " << max_length << "'" << std::endl;
+            out << "\t selected meta-path: " << (*metapath.begin())->init;
+            for (auto it = metapath.begin(); it!= metapath.end(); ++it) {
+                out << " -> " << (*it)->end;
+                }
+            out << std::endl;
 
-    {
-        std::cout << std::endl << "8) Search for actual path in the ORIGINAL graph (using last meta-path)" << std::endl;
-        std::vector<edge_ptr> metapath = success.tmp;
-        std::cout << "\t expected length: 'steps <= " << max_length << "'" << std::endl;
-        std::cout << "\t selected meta-path: " << (*metapath.begin())->init;
-        for (auto it = metapath.begin(); it!= metapath.end(); ++it) {
-            std::cout << " -> " << (*it)->end;
-            }
-        std::cout << std::endl;
-
-        std::cout << std::endl << "... press INTRO to continue" << std::endl; getchar();
-
-        AnCO::colony<algorithm::aco_multiobjetivo> search_colony(graph, cfg.n_ants_per_colony, max_length);
-        search_colony.set_base_node(start_node->id);
-        algorithm::aco_multiobjetivo::objective_list.clear();
-        float objective_price = 1/(float)metapath.size();
-        float sum_price = 0.f;
-        for (auto it = metapath.begin(); it!= metapath.end(); ++it) {
-            sum_price += objective_price;
-            int pherom_id = -1;
-            if ( (*it)->end == end_colony.get_base_node()) {
-                pherom_id = end_colony.get_id();
+            std::vector<edge_ptr> path;
+            bool found = refine && query.refine_path(metapath, path);
+            if (found) {
+                out << "\t (shortest path inside the corridor of the meta-path)" << std::endl;
                 }
             else {
-                for (auto c = colonies.begin(); c!=colonies.end(); ++c) {
-                    if ( (*it)->end == (*c)->get_base_node()) {
-                        pherom_id = (*c)->get_id();
-                        }
+                if (!headless) {
+                    out << std::endl << "... press INTRO to continue" << std::endl; getchar();
                     }
+                found = query.search_path(metapath, cfg.training_iterations+100, path, [&out](){ out << "." << std::flush; });
+                out << std::endl;
                 }
-            assert(pherom_id != -1);
-            algorithm::aco_multiobjetivo::objective_list[(*it)->end] = std::make_pair(pherom_id, sum_price);
-            }
-
-        //success_meta success(end_node->id);
-        iterations = 0;
-        success_node_found suc_multiobj(end_node->id);
-        while (++iterations < cfg.training_iterations+100) {
-            std::cout << ".";
-            colony_meta.run();
-            end_colony.run();
-            search_colony.run(suc_multiobj);
-            
-            colony_meta.update();
-            end_colony.update();
-            search_colony.update();
-            
-            colony_type::aco_algorithm_impl::update_graph(graph);        
-            std::cout << std::flush;
-            }
-        std::cout << std::endl;
-    }
+            if (found) {
+                out << "\t path found: " << path.size() << " steps, cost= '" << search_query::path_cost(path) << "'" << std::endl;
+                }
+            report();
+        }
+        }
 
 
-    std::cout << "Done" << std::endl;
-    getchar();
+    out << "Done" << std::endl;
+    if (!headless) {
+        getchar();
+        }
     return 0;
     }
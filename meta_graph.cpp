@@ -0,0 +1,165 @@
+
+#include "meta_graph.h"
+
+namespace AnCO {
+
+    meta_graph_maintainer::meta_graph_maintainer(std::size_t k, float threshold, float epsilon)
+        : epsilon(epsilon), proximity(k, threshold), version(0),
+          has_pending(false), busy(false), stop(false), unreported(0) {
+        std::shared_ptr<snapshot> empty = std::make_shared<snapshot>();
+        empty->version = 0;
+        empty->n_edges = 0;
+        current = empty;
+        worker = std::thread(&meta_graph_maintainer::run, this);
+        }
+
+    meta_graph_maintainer::~meta_graph_maintainer() {
+        {
+            std::lock_guard<std::mutex> lock(work_mutex);
+            stop = true;
+        }
+        wake.notify_one();
+        worker.join();
+        }
+
+    std::size_t meta_graph_maintainer::update(std::vector<graph::_t_node_id> base_nodes, std::vector<std::vector<float>> matrix) {
+        std::size_t changes;
+        {
+            std::lock_guard<std::mutex> lock(work_mutex);
+            pending_nodes.swap(base_nodes);
+            pending.swap(matrix);
+            has_pending = true;
+            changes = unreported;
+            unreported = 0;
+        }
+        wake.notify_one();
+        return changes;
+        }
+
+    bool meta_graph_maintainer::saturated(std::size_t& changes) {
+        std::lock_guard<std::mutex> lock(work_mutex);
+        if (!has_pending) {
+            return false;
+            }
+        changes = unreported;
+        unreported = 0;
+        return true;
+        }
+
+    void meta_graph_maintainer::flush() const {
+        std::unique_lock<std::mutex> lock(work_mutex);
+        idle.wait(lock, [this](){ return !has_pending && !busy; });
+        }
+
+    void meta_graph_maintainer::run() {
+        std::vector<graph::_t_node_id> base_nodes;
+        std::vector<std::vector<float>> matrix;
+        std::unique_lock<std::mutex> lock(work_mutex);
+        while (true) {
+            wake.wait(lock, [this](){ return stop || has_pending; });
+            if (stop) {
+                return;
+                }
+            base_nodes.swap(pending_nodes);
+            matrix.swap(pending);
+            has_pending = false;
+            busy = true;
+            lock.unlock();
+            const std::size_t changes = this->apply(base_nodes, matrix);
+            lock.lock();
+            busy = false;
+            unreported += changes;
+            idle.notify_all();
+            }
+        }
+
+    std::size_t meta_graph_maintainer::apply(const std::vector<graph::_t_node_id>& base_nodes, const std::vector<std::vector<float>>& matrix) {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        const std::size_t n = base_nodes.size();
+        std::size_t changes = 0;
+        if (proximity.n_rows() != n) {
+            // Different neighbourhood: start over
+            proximity.resize(n);
+            restored.assign(n, false);
+            rows.assign(n, _t_row());
+            dirty.assign(n, true);
+            changes += 1;
+            }
+        if (nodes != base_nodes) {
+            nodes = base_nodes;
+            changes += 1;
+            }
+        for (std::size_t i = 0; i<n && i<matrix.size(); ++i) {
+            const std::size_t n_cols = (std::min)(n, matrix[i].size());
+            if (restored[i]) {
+                bool learned = false;
+                for (std::size_t j = 0; j<n_cols && !learned; ++j) {
+                    learned = (j != i) && (matrix[i][j] > proximity.get_threshold());
+                    }
+                if (!learned) {
+                    continue;
+                    }
+                restored[i] = false;
+                }
+            const std::size_t row_changes = proximity.update_row(i, matrix[i], n_cols, epsilon);
+            if (row_changes) {
+                dirty[i] = true;
+                changes += row_changes;
+                }
+            }
+        if (changes) {
+            this->publish();
+            }
+        return changes;
+        }
+
+    sparse_proximity meta_graph_maintainer::get_proximity() const {
+        this->flush();
+        std::lock_guard<std::mutex> lock(state_mutex);
+        return proximity;
+        }
+
+    void meta_graph_maintainer::restore(const std::vector<graph::_t_node_id>& base_nodes, const sparse_proximity& prox) {
+        this->flush();
+        std::lock_guard<std::mutex> lock(state_mutex);
+        nodes = base_nodes;
+        proximity.resize(base_nodes.size());
+        restored.assign(base_nodes.size(), false);
+        rows.assign(base_nodes.size(), _t_row());
+        dirty.assign(base_nodes.size(), true);
+        for (std::size_t i = 0; i<prox.n_rows() && i<base_nodes.size(); ++i) {
+            proximity.set_row(i, prox.begin(i), prox.end(i));
+            restored[i] = true;
+            }
+        this->publish();
+        }
+
+    void meta_graph_maintainer::publish() {
+        // Only the rows that changed are rebuilt, the others are shared with the previous snapshot
+        for (std::size_t i = 0; i<rows.size(); ++i) {
+            if (dirty[i] || !rows[i]) {
+                std::shared_ptr<std::vector<edge>> row = std::make_shared<std::vector<edge>>();
+                row->reserve(proximity.end(i) - proximity.begin(i));
+                for (const sparse_proximity::entry* it = proximity.begin(i); it != proximity.end(i); ++it) {
+                    edge e = {std::uint32_t(i), it->col, 1 - it->value};
+                    row->push_back(e);
+                    }
+                rows[i] = row;
+                dirty[i] = false;
+                }
+            }
+        std::shared_ptr<snapshot> s = std::make_shared<snapshot>();
+        s->version = ++version;
+        s->nodes = nodes;
+        s->rows = rows;
+        s->n_edges = proximity.n_entries();
+        std::lock_guard<std::mutex> lock(mutex);
+        current = s;
+        }
+
+    meta_graph_maintainer::_t_ptr meta_graph_maintainer::get() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return current;
+        }
+
+    }
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+
+#include "jgsogo/AnCO/graph/graph.h"
+#include "sparse_proximity.h"
+
+namespace AnCO {
+
+    /*
+    Meta-graph of the neighbourhood kept up to date while it trains: one node
+    per colony (its base node) and an edge 'i -> j' with 'cost = 1-proximity'
+    for each of the 'k' closest colonies of 'i' with proximity above
+    'threshold' (see 'sparse_proximity').
+
+    'update' is called after every iteration of the neighbourhood (with the
+    pipeline mutex held) and only takes the proximity matrix of the
+    neighbourhood; the maintenance runs in a thread of its own. It only
+    touches the rows that changed: an edge is added or removed when its
+    proximity crosses the threshold (or leaves the top-k) and re-weighted
+    when it moves more than 'epsilon'. If the thread is still busy with the
+    previous matrix, the new one replaces the one waiting (only the latest
+    matters).
+
+    If anything changed, a new immutable snapshot is published; it shares
+    the edges of the rows that didn't change with the previous one, so a
+    publication costs the changed rows, not the whole meta-graph. Queries
+    take the current one with 'get()' without waiting for the training and
+    only have to attach their start/end nodes.
+    */
+    class meta_graph_maintainer {
+        public:
+            struct edge {
+                std::uint32_t from, to; // index of the colony
+                float cost;
+                };
+            typedef std::shared_ptr<const std::vector<edge>> _t_row;
+            struct snapshot {
+                unsigned int version;
+                std::vector<graph::_t_node_id> nodes; // base node of each colony
+                std::vector<_t_row> rows;             // edges leaving each colony
+                std::size_t n_edges;
+                };
+            typedef std::shared_ptr<const snapshot> _t_ptr;
+
+            meta_graph_maintainer(std::size_t k = 16, float threshold = 0.f, float epsilon = 0.01f);
+            ~meta_graph_maintainer();
+
+            // Hands the proximity matrix of the neighbourhood to the maintenance thread (caller holds the
+            // pipeline mutex). Returns the number of edges added, removed or re-weighted since the previous
+            // call (so the changes of an iteration are reported by the next one). The library only gives
+            // the matrix dense (colonies^2), so it isn't even read while a previous one is still waiting;
+            // 'before_read' runs right before it is (e.g. settle the pending evaporation it is computed from).
+            template <class neighbourhood_t>
+            std::size_t update(neighbourhood_t& neighbourhood, const std::function<void()>& before_read = std::function<void()>()) {
+                std::size_t changes;
+                if (this->saturated(changes)) {
+                    return changes;
+                    }
+                if (before_read) {
+                    before_read();
+                    }
+                auto colonies = neighbourhood.get_colonies();
+                std::vector<graph::_t_node_id> base_nodes;
+                base_nodes.reserve(colonies.size());
+                for (auto it = colonies.begin(); it != colonies.end(); ++it) {
+                    base_nodes.push_back((*it)->get_base_node());
+                    }
+                return this->update(std::move(base_nodes), neighbourhood.get_proximity_matrix());
+                };
+            std::size_t update(std::vector<graph::_t_node_id> base_nodes, std::vector<std::vector<float>> proximity);
+            // Waits until the last matrix handed to 'update' is applied and published.
+            void flush() const;
+
+            // Sparse proximity as of the last update and restore from a checkpoint. The proximity of the
+            //  library colonies can't be set from outside, so a restored row is kept until the neighbourhood
+            //  has some proximity of its own for that colony.
+            sparse_proximity get_proximity() const;
+            std::size_t max_neighbours() const { return proximity.max_neighbours(); };
+            void restore(const std::vector<graph::_t_node_id>& base_nodes, const sparse_proximity& prox);
+
+            _t_ptr get() const;
+
+        protected:
+            void run();
+            bool saturated(std::size_t& changes);
+            std::size_t apply(const std::vector<graph::_t_node_id>& base_nodes, const std::vector<std::vector<float>>& matrix);
+            void publish();
+
+            // State of the maintenance thread ('state_mutex')
+            float epsilon;
+            std::vector<graph::_t_node_id> nodes;
+            sparse_proximity proximity;
+            std::vector<bool> restored;         // rows still as restored from a checkpoint
+            std::vector<_t_row> rows;
+            std::vector<bool> dirty;            // rows to rebuild in the next publication
+            unsigned int version;
+            mutable std::mutex state_mutex;
+
+            // Hand-off to the maintenance thread ('work_mutex')
+            std::vector<graph::_t_node_id> pending_nodes;
+            std::vector<std::vector<float>> pending;
+            bool has_pending, busy, stop;
+            std::size_t unreported;
+            mutable std::mutex work_mutex;
+            mutable std::condition_variable wake, idle;
+
+            mutable std::mutex mutex;
+            _t_ptr current;
+
+            std::thread worker;
+        };
+
+    }
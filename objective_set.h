@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+
+#include "jgsogo/AnCO/graph/graph.h"
+
+namespace AnCO {
+
+    namespace algorithm {
+
+        /*
+        Objectives of a multi-objective search: the base nodes of the colonies
+        along a meta-path, the pheromone each one deposits and its price. The
+        set is immutable once built, so it can be shared between threads (and
+        concurrent searches) without locking. Each set has a unique 'id', so
+        per-thread tables derived from it ('ant_scratch') are only rebuilt when
+        the set changes.
+        */
+        class objective_set {
+            public:
+                struct objective {
+                    objective(const graph::_t_node_id& node, unsigned int pherom_id, float price) : node(node), pherom_id(pherom_id), price(price) {};
+                    graph::_t_node_id node;
+                    unsigned int pherom_id;
+                    float price;
+                    };
+                typedef std::shared_ptr<const objective_set> _t_ptr;
+
+                // Objectives are sorted by priority: highest price first (the last one of the meta-path).
+                static _t_ptr make(std::vector<objective> objectives) {
+                    std::stable_sort(objectives.begin(), objectives.end(), [](const objective& lhs, const objective& rhs){ return lhs.price > rhs.price;});
+                    return _t_ptr(new objective_set(std::move(objectives)));
+                    };
+
+                std::uint64_t get_id() const { return id; };
+                std::size_t size() const { return objectives.size(); };
+                bool empty() const { return objectives.empty(); };
+                const objective& operator[](std::size_t i) const { return objectives[i]; };
+                std::vector<objective>::const_iterator begin() const { return objectives.begin(); };
+                std::vector<objective>::const_iterator end() const { return objectives.end(); };
+
+            protected:
+                objective_set(std::vector<objective>&& objectives) : id(next_id()), objectives(std::move(objectives)) {};
+                static std::uint64_t next_id() {
+                    static std::atomic<std::uint64_t> n(0);
+                    return ++n;
+                    };
+                const std::uint64_t id;
+                const std::vector<objective> objectives;
+            };
+
+        }
+    }
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+
+#include "jgsogo/AnCO/colony/neighbourhood.h"
+#include "work_stealing_pool.h"
+#include "counter_rng.h"
+#include "graph_index.h"
+#include "lazy_evaporation.h"
+
+namespace AnCO {
+
+    /*
+    Collects the 'run' step of several colonies into one batch for the
+    'work_stealing_pool'. Ants of different colonies are independent until
+    the 'update' step, so the batch runs concurrently and 'run()' returns
+    once all of them have finished: updates and evaporation must be done
+    after it, as in the sequential loop.
+
+        parallel_run(pool).add(colony_meta).add(start_colony).run();
+        colony_meta.update(); start_colony.update();
+        colony_type::aco_algorithm_impl::update_graph(graph);
+
+    Colonies whose algorithm draws from 'random_streams' (see
+    'draws_from_streams', e.g. 'aco_random_streams') need no lock: each one
+    is a task of its own, also the colonies of a neighbourhood ('run()' of
+    the neighbourhood only runs them; the pipelines count their own
+    iterations). The ACO algorithms of the library share one random
+    generator, so every other colony goes to a single task that runs them
+    one after the other, in the order they were added, holding
+    'library_rng_mutex': the numbers they get are the ones of the sequential
+    loop (a neighbourhood of them runs there through its own 'run()').
+    'add_task' tasks run concurrently with all of them; a task that draws
+    from the generator of the library takes the lock for each draw.
+
+    Every task sees the 'graph_index' and 'lazy_evaporation' installed in
+    the thread that calls 'run()' (their scopes are per thread).
+    */
+    class parallel_run {
+        public:
+            parallel_run(work_stealing_pool& pool) : pool(pool) {};
+
+            template <class aco_algorithm, class prox_algorithm>
+            parallel_run& add(neighbourhood<aco_algorithm, prox_algorithm>& n) {
+                if (!draws_from_streams<aco_algorithm>::value) {
+                    return this->add_colony<aco_algorithm>([&n](){ n.run(); });
+                    }
+                auto colonies = n.get_colonies();
+                for (auto it = colonies.begin(); it != colonies.end(); ++it) {
+                    auto c = *it;
+                    tasks.push_back([c](){ c->run(); });
+                    }
+                return *this;
+                };
+
+            template <class colony_t>
+            parallel_run& add(colony_t& c) {
+                return this->add_colony<typename colony_t::aco_algorithm_impl>([&c](){ c.run(); });
+                };
+
+            template <class colony_t, class success_t>
+            parallel_run& add(colony_t& c, success_t& suc) {
+                return this->add_colony<typename colony_t::aco_algorithm_impl>([&c, &suc](){ c.run(suc); });
+                };
+
+            parallel_run& add_task(const work_stealing_pool::_t_task& task) {
+                tasks.push_back(task);
+                return *this;
+                };
+
+            void run() {
+                const graph_index* index = graph_index::current();
+                lazy_evaporation* evaporation = lazy_evaporation::current();
+                if (!shared_rng.empty()) {
+                    std::vector<work_stealing_pool::_t_task> serial;
+                    serial.swap(shared_rng);
+                    tasks.push_back([serial](){
+                        std::lock_guard<std::recursive_mutex> lock(library_rng_mutex());
+                        for (auto it = serial.begin(); it != serial.end(); ++it) {
+                            (*it)();
+                            }
+                        });
+                    }
+                for (auto it = tasks.begin(); it != tasks.end(); ++it) {
+                    work_stealing_pool::_t_task task;
+                    task.swap(*it);
+                    *it = [task, index, evaporation](){
+                        graph_index::scope index_scope(index);
+                        lazy_evaporation::scope evaporation_scope(evaporation);
+                        task();
+                        };
+                    }
+                pool.run(tasks);
+                tasks.clear();
+                };
+
+        protected:
+            template <class aco_algorithm>
+            parallel_run& add_colony(const work_stealing_pool::_t_task& task) {
+                (draws_from_streams<aco_algorithm>::value ? tasks : shared_rng).push_back(task);
+                return *this;
+                };
+
+            work_stealing_pool& pool;
+            std::vector<work_stealing_pool::_t_task> tasks;
+            std::vector<work_stealing_pool::_t_task> shared_rng; // one task, in order
+        };
+
+    }
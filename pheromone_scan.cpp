@@ -0,0 +1,107 @@
+
+#include "pheromone_scan.h"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define ANCO_PHEROMONE_SSE2
+#endif
+
+namespace AnCO {
+
+    namespace algorithm {
+
+        namespace {
+            // Scalar tail (and fallback): strict '>' keeps the first maximum.
+            inline void scan_scalar(const float* row, std::size_t begin, std::size_t n, float& best, std::size_t& best_index) {
+                for (std::size_t i = begin; i<n; ++i) {
+                    if (row[i] > best) {
+                        best = row[i];
+                        best_index = i;
+                        }
+                    }
+                }
+            }
+
+        std::size_t pheromone_row_argmax(const float* row, std::size_t n, float threshold, float& value) {
+            float best = threshold;
+            std::size_t best_index = n;
+            std::size_t i = 0;
+
+        #if defined(__AVX2__)
+            if (n >= 8) {
+                // Each lane keeps its own maximum and the index where it was first seen
+                __m256 vbest = _mm256_set1_ps(threshold);
+                __m256i vindex = _mm256_set1_epi32(-1);
+                __m256i vcurrent = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+                const __m256i vstep = _mm256_set1_epi32(8);
+                for (; i+8<=n; i+=8) {
+                    __m256 v = _mm256_loadu_ps(row + i);
+                    __m256 greater = _mm256_cmp_ps(v, vbest, _CMP_GT_OQ);
+                    vbest = _mm256_blendv_ps(vbest, v, greater);
+                    vindex = _mm256_blendv_epi8(vindex, vcurrent, _mm256_castps_si256(greater));
+                    vcurrent = _mm256_add_epi32(vcurrent, vstep);
+                    }
+                float lanes[8];
+                int indexes[8];
+                _mm256_storeu_ps(lanes, vbest);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(indexes), vindex);
+                for (int l = 0; l<8; ++l) {
+                    if (indexes[l] >= 0 && ((lanes[l] > best) || (lanes[l] == best && std::size_t(indexes[l]) < best_index))) {
+                        best = lanes[l];
+                        best_index = std::size_t(indexes[l]);
+                        }
+                    }
+                }
+        #elif defined(ANCO_PHEROMONE_SSE2)
+            if (n >= 4) {
+                __m128 vbest = _mm_set1_ps(threshold);
+                __m128i vindex = _mm_set1_epi32(-1);
+                __m128i vcurrent = _mm_setr_epi32(0, 1, 2, 3);
+                const __m128i vstep = _mm_set1_epi32(4);
+                for (; i+4<=n; i+=4) {
+                    __m128 v = _mm_loadu_ps(row + i);
+                    __m128 greater = _mm_cmpgt_ps(v, vbest);
+                    __m128i mask = _mm_castps_si128(greater);
+                    vbest = _mm_or_ps(_mm_and_ps(greater, v), _mm_andnot_ps(greater, vbest));
+                    vindex = _mm_or_si128(_mm_and_si128(mask, vcurrent), _mm_andnot_si128(mask, vindex));
+                    vcurrent = _mm_add_epi32(vcurrent, vstep);
+                    }
+                float lanes[4];
+                int indexes[4];
+                _mm_storeu_ps(lanes, vbest);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(indexes), vindex);
+                for (int l = 0; l<4; ++l) {
+                    if (indexes[l] >= 0 && ((lanes[l] > best) || (lanes[l] == best && std::size_t(indexes[l]) < best_index))) {
+                        best = lanes[l];
+                        best_index = std::size_t(indexes[l]);
+                        }
+                    }
+                }
+        #endif
+            scan_scalar(row, i, n, best, best_index);
+            value = best;
+            return best_index;
+            }
+
+        void pheromone_row_scale(float* row, std::size_t n, float factor) {
+            std::size_t i = 0;
+        #if defined(__AVX2__)
+            const __m256 vfactor = _mm256_set1_ps(factor);
+            for (; i+8<=n; i+=8) {
+                _mm256_storeu_ps(row + i, _mm256_mul_ps(_mm256_loadu_ps(row + i), vfactor));
+                }
+        #elif defined(ANCO_PHEROMONE_SSE2)
+            const __m128 vfactor = _mm_set1_ps(factor);
+            for (; i+4<=n; i+=4) {
+                _mm_storeu_ps(row + i, _mm_mul_ps(_mm_loadu_ps(row + i), vfactor));
+                }
+        #endif
+            for (; i<n; ++i) {
+                row[i] *= factor;
+                }
+            }
+
+        }
+    }
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+namespace AnCO {
+
+    namespace algorithm {
+
+        // Pheromone a colony has to leave on an edge for it to count as part of its trail: the objectives
+        //  of 'aco_multiobjetivo' and the corridors of 'corridor_path' look for the same edges.
+        const float pheromone_threshold = 0.01f;
+
+        /*
+        Threshold-and-argmax over a contiguous row of pheromone values: returns
+        the index of the first maximum among the values strictly greater than
+        'threshold' (and writes it to 'value'), or 'n' if there is none.
+
+        It is a single pass with AVX2 or SSE2 when the compiler targets them
+        (define ANCO_USE_AVX2 in CMake to build with -mavx2), scalar otherwise.
+        */
+        std::size_t pheromone_row_argmax(const float* row, std::size_t n, float threshold, float& value);
+
+        // 'row[i] *= factor' for the 'n' values (evaporation), same instruction set as above.
+        void pheromone_row_scale(float* row, std::size_t n, float factor);
+
+        // Result of the selection over (objectives x edges): first objective with a hit and its best edge.
+        struct pheromone_pick {
+            std::size_t objective;  // number of objectives if nothing is above the threshold
+            std::size_t edge;
+            float value;
+            };
+
+        }
+    }
@@ -0,0 +1,83 @@
+
+#include "pipeline_metrics.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace AnCO {
+
+    namespace {
+        const char* phase_names[pipeline_metrics::n_phases] = {"run", "update", "evaporation"};
+        }
+
+    pipeline_metrics::histogram::histogram() : n(0), sum(0.), max_value(0.) {
+        buckets.fill(0);
+        }
+
+    void pipeline_metrics::histogram::add(double seconds) {
+        double us = seconds*1e6;
+        std::size_t bucket = (us < 1.) ? 0 : std::size_t(std::log2(us)) + 1;
+        ++buckets[(std::min)(bucket, n_buckets-1)];
+        ++n;
+        sum += seconds;
+        max_value = (std::max)(max_value, seconds);
+        }
+
+    double pipeline_metrics::histogram::quantile(double q) const {
+        if (n == 0) {
+            return 0.;
+            }
+        std::uint64_t rank = std::uint64_t(std::ceil(q*n)), acc = 0;
+        for (std::size_t i = 0; i<n_buckets; ++i) {
+            acc += buckets[i];
+            if (acc >= rank && acc > 0) {
+                return (std::min)(std::ldexp(1., int(i))*1e-6, max_value);
+                }
+            }
+        return max_value;
+        }
+
+    pipeline_metrics::pipeline_metrics()
+        : t0(clock::now()), iterations(0), ants(0), searching_ants(0), successful_ants(0), successful_steps(0), queries(0) {
+        }
+
+    void pipeline_metrics::add_time(phase p, double seconds) {
+        std::lock_guard<std::mutex> lock(mutex);
+        phases[p].add(seconds);
+        }
+
+    void pipeline_metrics::add_search(std::uint64_t n_ants, std::uint64_t n_successful, std::uint64_t steps) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ants += n_ants;
+        searching_ants += n_ants;
+        successful_ants += n_successful;
+        successful_steps += steps;
+        }
+
+    void pipeline_metrics::write_json(std::ostream& os, unsigned int iteration) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        double elapsed = std::chrono::duration<double>(clock::now() - t0).count();
+        os << "{\"iteration\": " << iteration
+           << ", \"elapsed_s\": " << elapsed
+           << ", \"iterations\": " << iterations
+           << ", \"iterations_per_s\": " << (elapsed > 0. ? iterations/elapsed : 0.)
+           << ", \"ants\": " << ants
+           << ", \"searching_ants\": " << searching_ants
+           << ", \"successful_ants\": " << successful_ants
+           << ", \"success_rate\": " << (searching_ants ? double(successful_ants)/searching_ants : 0.)
+           << ", \"mean_path_length\": " << (successful_ants ? double(successful_steps)/successful_ants : 0.)
+           << ", \"queries\": " << queries
+           << ", \"phases\": {";
+        for (std::size_t p = 0; p<n_phases; ++p) {
+            const histogram& h = phases[p];
+            os << (p ? ", " : "") << "\"" << phase_names[p] << "\": {\"count\": " << h.count()
+               << ", \"total_s\": " << h.total()
+               << ", \"mean_s\": " << (h.count() ? h.total()/h.count() : 0.)
+               << ", \"p50_s\": " << h.quantile(0.5)
+               << ", \"p95_s\": " << h.quantile(0.95)
+               << ", \"max_s\": " << h.max() << "}";
+            }
+        os << "}}" << std::endl;
+        }
+
+    }
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+
+namespace AnCO {
+
+    /*
+    Counters and latency histograms of the search, cheap enough to be always
+    on. Every iteration (training, query and path search) adds the ants it
+    launched and the time spent in each phase: 'run' (ants walking), 'update'
+    (pheromone deposit of every colony) and 'evaporation' ('update_graph').
+    Searches with a target (meta-path and path) also report the ants that
+    reached it and the length of their paths.
+
+    'write_json' dumps the current state as one JSON object per line, so a
+    headless run can be followed with 'tail -f' or parsed afterwards.
+    */
+    class pipeline_metrics {
+        public:
+            enum phase { phase_run = 0, phase_update, phase_evaporation, n_phases };
+            typedef std::chrono::steady_clock clock;
+
+            // Log2 buckets over microseconds: [0,1), [1,2), [2,4)... up to ~35 min.
+            class histogram {
+                public:
+                    static const std::size_t n_buckets = 32;
+                    histogram();
+                    void add(double seconds);
+                    std::uint64_t count() const { return n; };
+                    double total() const { return sum; };
+                    double max() const { return max_value; };
+                    double quantile(double q) const; // upper bound of the bucket
+                protected:
+                    std::array<std::uint64_t, n_buckets> buckets;
+                    std::uint64_t n;
+                    double sum, max_value;
+                };
+
+            // Adds the elapsed time to 'phase' on destruction.
+            class scoped_timer {
+                public:
+                    scoped_timer(pipeline_metrics& metrics, phase p) : metrics(metrics), p(p), t0(clock::now()) {};
+                    ~scoped_timer() { metrics.add_time(p, std::chrono::duration<double>(clock::now() - t0).count()); };
+                protected:
+                    pipeline_metrics& metrics;
+                    phase p;
+                    clock::time_point t0;
+                private:
+                    scoped_timer(const scoped_timer&);
+                    scoped_timer& operator=(const scoped_timer&);
+                };
+
+            pipeline_metrics();
+
+            void add_time(phase p, double seconds);
+            void add_iteration() { std::lock_guard<std::mutex> lock(mutex); ++iterations; };
+            void add_ants(std::uint64_t n) { std::lock_guard<std::mutex> lock(mutex); ants += n; };
+            void add_search(std::uint64_t n_ants, std::uint64_t n_successful, std::uint64_t successful_steps);
+            void add_query() { std::lock_guard<std::mutex> lock(mutex); ++queries; };
+
+            void write_json(std::ostream& os, unsigned int iteration) const;
+
+        protected:
+            mutable std::mutex mutex;
+            clock::time_point t0;
+            std::uint64_t iterations, ants, searching_ants, successful_ants, successful_steps, queries;
+            std::array<histogram, n_phases> phases;
+        };
+
+    }
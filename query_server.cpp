@@ -0,0 +1,146 @@
+
+#include "query_server.h"
+
+#include <sstream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "hierarchy.h"
+
+namespace AnCO {
+
+    query_server::query_server(search_pipeline& pipeline, const graph_snapshot& snapshot, bool refine, std::size_t portfolio, float portfolio_bound)
+        : pipeline(pipeline), snapshot(snapshot), refine(refine), portfolio(portfolio), portfolio_bound(portfolio_bound), busy(false), stop(true) {
+        }
+
+    query_server::~query_server() {
+        this->stop_background();
+        }
+
+    void query_server::start_background() {
+        if (thread.joinable()) {
+            return;
+            }
+        stop = false;
+        thread = std::thread(&query_server::background, this);
+        }
+
+    void query_server::stop_background() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+        if (thread.joinable()) {
+            thread.join();
+            }
+        }
+
+    void query_server::background() {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this](){ return stop || (!busy && !pipeline.converged()); });
+                if (stop) {
+                    return;
+                    }
+            }
+            pipeline.iterate();
+            }
+        }
+
+    std::size_t query_server::update(const graph_updates& updates) {
+        const std::size_t changed = pipeline.apply_updates(updates);
+        cv.notify_all();
+        return changed;
+        }
+
+    std::size_t query_server::serve(std::istream& is, std::ostream& os) {
+        typedef std::chrono::steady_clock clock;
+        std::vector<double> latencies;
+        clock::time_point serve_start = clock::now();
+
+        std::string line;
+        graph_updates updates;
+        while (std::getline(is, line)) {
+            if (!line.empty() && line[0] == '!') {
+                if (!updates.parse(line.substr(1))) {
+                    os << "# bad update: " << line << std::endl;
+                    }
+                continue;
+                }
+            std::istringstream ls(line);
+            graph::_t_node_id start, end;
+            if (line.empty() || line[0] == '#' || !(ls >> start >> end)) {
+                continue;
+                }
+            graph_snapshot::_t_index index;
+            if (!snapshot.find(start, index) || !snapshot.find(end, index)) {
+                os << "# unknown node: " << (snapshot.find(start, index) ? end : start) << std::endl;
+                continue;
+                }
+            if (updates.size()) {
+                os << "# updated " << this->update(updates) << " edges" << std::endl;
+                updates.clear();
+                }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busy = true;
+            }
+            clock::time_point query_start = clock::now();
+
+            std::vector<edge_ptr> metapath, path;
+            bool found = false;
+            std::string error;
+            try {
+                if (search_hierarchy* hierarchy = pipeline.get_hierarchy()) {
+                    hierarchy->refresh(pipeline.get_config().training_iterations); // between queries: nobody descends it
+                    }
+                search_query query(pipeline, start, end);
+                found = query.answer(metapath, path, refine, portfolio, portfolio_bound);
+                }
+            catch (std::exception& e) {
+                error = e.what(); // e.g. a colony of the query without pheromone slot (see 'check_colony_id')
+                }
+
+            double latency = std::chrono::duration<double, std::milli>(clock::now() - query_start).count();
+            latencies.push_back(latency);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busy = false;
+            }
+            cv.notify_all();
+
+            if (!error.empty()) {
+                os << "# error: " << start << " " << end << ": " << error << std::endl;
+                continue;
+                }
+            os << start << " " << end << " " << (found ? 1 : 0) << " " << metapath.size() << " " << path.size()
+               << " " << (found ? search_query::path_cost(path) : 0.f) << " " << latency << std::endl;
+            }
+        if (updates.size()) {
+            os << "# updated " << this->update(updates) << " edges" << std::endl;
+            }
+
+        double elapsed = std::chrono::duration<double>(clock::now() - serve_start).count();
+        if (!latencies.empty()) {
+            std::vector<double> sorted(latencies);
+            std::sort(sorted.begin(), sorted.end());
+            double sum = 0.;
+            for (auto it = sorted.begin(); it != sorted.end(); ++it) {
+                sum += *it;
+                }
+            os << "# queries: " << sorted.size()
+               << " | throughput: " << sorted.size()/elapsed << " queries/s"
+               << " | latency (ms) mean: " << sum/sorted.size()
+               << " p50: " << sorted[sorted.size()/2]
+               << " p95: " << sorted[(sorted.size()*95)/100]
+               << " max: " << sorted.back() << std::endl;
+            }
+        return latencies.size();
+        }
+
+    }
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#include "search_pipeline.h"
+#include "graph_snapshot.h"
+
+namespace AnCO {
+
+    /*
+    Batch/query mode: the neighbourhood is trained once and kept warm by a
+    background thread while a stream of '<start> <end>' queries (one per
+    line) is answered. Each query only trains its own start/end colonies and
+    searches its meta-graph; background iterations pause while a query runs.
+    With 'refine' the path is taken from the corridor of the meta-path
+    whenever there is one (see 'search_query::refine_path'). The background
+    thread goes to sleep once the neighbourhood has converged. With a
+    'portfolio' of N > 1 the best N meta-paths are raced for every query
+    until one finds a path with 'cost <= portfolio_bound' (see
+    'search_query::race_paths').
+
+    Lines starting with '!' are changes to the graph ('graph_updates' text
+    format); consecutive ones are applied as one batch before the next query
+    and wake the background training up. The levels of a hierarchy are stale
+    after them: queries search the flat meta-graph until the neighbourhood
+    has retrained, and the first query after that builds the levels again
+    (see 'search_hierarchy::refresh').
+
+    For every query a line is written to the output:
+        <start> <end> <found> <metapath_steps> <path_steps> <path_cost> <latency_ms>
+    and a summary with throughput and latency figures at the end. Queries
+    with a node that is not in the graph get a '# unknown node' line instead,
+    and queries that fail (e.g. a colony without pheromone slot) an
+    '# error' line.
+    Nothing else is written to the output: the caller keeps every other
+    writer (e.g. 'aco_multiobjetivo::set_trace') off that stream.
+    */
+    class query_server {
+        public:
+            query_server(search_pipeline& pipeline, const graph_snapshot& snapshot, bool refine = false, std::size_t portfolio = 1,
+                         float portfolio_bound = (std::numeric_limits<float>::max)());
+            ~query_server();
+
+            void start_background();
+            void stop_background();
+
+            // Answers every query in 'is' and returns the number of queries served.
+            std::size_t serve(std::istream& is, std::ostream& os);
+            // Applies a batch of changes to the graph (between iterations) and resumes the background training.
+            std::size_t update(const graph_updates& updates);
+
+        protected:
+            void background();
+
+            search_pipeline& pipeline;
+            const graph_snapshot& snapshot;
+            bool refine;
+            std::size_t portfolio;
+            float portfolio_bound;
+            std::thread thread;
+            std::mutex mutex;
+            std::condition_variable cv;
+            bool busy;
+            bool stop;
+        };
+
+    }
@@ -0,0 +1,601 @@
+
+#include "search_pipeline.h"
+
+#include <numeric>
+#include <limits>
+#include <cassert>
+#include <set>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "parallel_run.h"
+#include "corridor_path.h"
+#include "pheromone_scan.h"
+#include "hierarchy.h"
+
+namespace AnCO {
+
+    namespace {
+        // Signals of a search with a target: new unique paths in this iteration and best cost so far
+        // New paths and best cost of a search. Nothing is stable before the first path is found (both
+        //  signals would stay at 0), so the window only starts counting from it.
+        bool search_converged(convergence_monitor& monitor, const success_meta& success, std::size_t& unique_paths) {
+            const std::size_t new_paths = success.hash_paths.inserted() - unique_paths;
+            unique_paths = success.hash_paths.inserted();
+            if (success.costs.empty()) {
+                monitor.reset();
+                return false;
+                }
+            std::vector<double> values;
+            values.push_back(double(new_paths));
+            values.push_back(double(success.costs.front()));
+            return monitor.add(values);
+            }
+        }
+
+    void check_colony_id(unsigned int id) {
+        if (id >= N_MAX_COLONIES) {
+            throw std::runtime_error("colony " + std::to_string(id) + " has no pheromone slot (N_MAX_COLONIES = "
+                                     + std::to_string(N_MAX_COLONIES) + ", cmake -DANCO_N_MAX_COLONIES=...)");
+            }
+        }
+
+    search_pipeline::search_pipeline(graph& graph, graph_index& index, const config& cfg, work_stealing_pool& pool)
+        : g(graph), index(index), cfg(cfg), pool(pool), colony_meta(graph, cfg.n_colonies, cfg.n_ants_per_colony, cfg.max_steps), iteration(0), evaporation(nullptr), hierarchy(nullptr), training_converged(false) {
+        auto colonies = colony_meta.get_colonies();
+        for (auto c = colonies.begin(); c != colonies.end(); ++c) {
+            check_colony_id((*c)->get_id());
+            }
+        }
+
+    std::size_t search_pipeline::apply_updates(const graph_updates& updates) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const std::size_t changed = updates.apply(g, &index, evaporation);
+        if (changed) {
+            training.reset();
+            training_converged.store(false);
+            if (hierarchy) {
+                hierarchy->invalidate();
+                }
+            }
+        return changed;
+        }
+
+    std::size_t search_pipeline::update_meta_graph() {
+        return meta_graph.update(colony_meta, [this](){
+            if (evaporation) {
+                evaporation->compact(pool);
+                }
+            });
+        }
+
+    void search_pipeline::evaporate() {
+        if (evaporation) {
+            evaporation->advance();
+            return;
+            }
+        // 'update_graph' only knows the edges of the library: the ones inserted into the index
+        //  ('graph_updates') decay by the factor it applied to a slot of a snapshot edge
+        const std::vector<edge_ptr>& edges = index.get_edges();
+        const std::size_t n_snapshot = edges.size() - index.n_inserted();
+        const edge_ptr::element_type* sample = nullptr;
+        std::size_t slot = 0;
+        float before = 0.f;
+        for (std::size_t e = 0; e<n_snapshot && index.n_inserted() && !sample; ++e) {
+            for (slot = 0; slot<N_MAX_COLONIES; ++slot) {
+                if (edges[e]->data.pheromone[slot] > 0.f) {
+                    sample = edges[e].get();
+                    before = sample->data.pheromone[slot];
+                    break;
+                    }
+                }
+            }
+        colony_type::aco_algorithm_impl::update_graph(g);
+        if (sample) {
+            const float factor = sample->data.pheromone[slot]/before;
+            for (std::size_t e = n_snapshot; e<edges.size(); ++e) {
+                algorithm::pheromone_row_scale(edges[e]->data.pheromone, N_MAX_COLONIES, factor);
+                }
+            }
+        }
+
+    void search_pipeline::iterate() {
+        std::lock_guard<std::mutex> lock(mutex);
+        lazy_evaporation::scope evaporation_scope(evaporation);
+        graph_index::scope index_scope(&index); // the neighbourhood walks the live graph (see 'aco_random_streams')
+        std::size_t changes = 0;
+        {
+            pipeline_metrics::scoped_timer t(metrics, pipeline_metrics::phase_run);
+            parallel_run(pool).add(colony_meta).run();
+        }
+        {
+            pipeline_metrics::scoped_timer t(metrics, pipeline_metrics::phase_update);
+            colony_meta.update();
+            changes = this->update_meta_graph();
+        }
+        {
+            pipeline_metrics::scoped_timer t(metrics, pipeline_metrics::phase_evaporation);
+            this->evaporate();
+        }
+        metrics.add_iteration();
+        metrics.add_ants(this->ants_per_iteration());
+        ++iteration;
+
+        // Convergence: metric of every colony and edges of the meta-graph that changed
+        auto colonies = colony_meta.get_colonies();
+        std::vector<double> values;
+        for (auto it = colonies.begin(); it != colonies.end(); ++it) {
+            values.push_back((*it)->get_metric());
+            }
+        values.push_back(double(changes));
+        training.add(values);
+        training_converged.store(training.converged());
+        if (listener) {
+            listener(*this);
+            }
+        }
+
+
+    search_query::search_query(search_pipeline& pipeline, const graph::_t_node_id& start, const graph::_t_node_id& end)
+        : pipeline(pipeline), start(start), end(end),
+          start_colony(pipeline.get_graph(), pipeline.get_config().n_ants_per_colony, pipeline.get_config().max_steps),
+          end_colony(pipeline.get_graph(), pipeline.get_config().n_ants_per_colony, pipeline.get_config().max_steps),
+          meta_success(end), training(pipeline.get_convergence()) {
+        check_colony_id(start_colony.get_id());
+        check_colony_id(end_colony.get_id());
+        start_colony.set_base_node(start);
+        end_colony.set_base_node(end);
+        auto colonies = pipeline.get_neighbourhood().get_colonies();
+        for (auto c = colonies.begin(); c != colonies.end(); ++c) {
+            colony_slots[(*c)->get_base_node()] = (*c)->get_id();
+            }
+        colony_slots[end_colony.get_base_node()] = end_colony.get_id();
+        }
+
+    bool search_query::iterate() {
+        std::lock_guard<std::mutex> lock(pipeline.get_mutex());
+        lazy_evaporation::scope evaporation_scope(pipeline.get_lazy_evaporation());
+        graph_index::scope index_scope(&pipeline.get_index());
+        neighbourhood_type& colony_meta = pipeline.get_neighbourhood();
+        pipeline_metrics& metrics = pipeline.get_metrics();
+        std::size_t changes = 0;
+        {
+            pipeline_metrics::scoped_timer t(metrics, pipeline_metrics::phase_run);
+            parallel_run(pipeline.get_pool()).add(colony_meta).add(start_colony).add(end_colony).run();
+        }
+        {
+            pipeline_metrics::scoped_timer t(metrics, pipeline_metrics::phase_update);
+            colony_meta.update();
+            start_colony.update();
+            end_colony.update();
+            changes = pipeline.update_meta_graph();
+        }
+        {
+            pipeline_metrics::scoped_timer t(metrics, pipeline_metrics::phase_evaporation);
+            pipeline.evaporate();
+        }
+        metrics.add_iteration();
+        metrics.add_ants(pipeline.ants_per_iteration() + 2*pipeline.get_config().n_ants_per_colony);
+
+        // Convergence: start/end colonies and the meta-graph they will be attached to
+        std::vector<double> values;
+        values.push_back(start_colony.get_metric());
+        values.push_back(end_colony.get_metric());
+        values.push_back(double(changes));
+        return training.add(values);
+        }
+
+    bool search_query::reachable() const {
+        return (start_colony.get_metric() > 0.f) && (end_colony.get_metric() > 0.f);
+        }
+
+    void search_query::build_meta_graph(std::ostream* log) {
+        meta_dataset.reset(new graph_data_file_builder());
+        std::vector<float> prox_start, prox_end;
+        meta_graph_maintainer::_t_ptr meta;
+        {
+            std::lock_guard<std::mutex> lock(pipeline.get_mutex());
+            auto ps = start_colony.get_proximity_vector();
+            auto pe = end_colony.get_proximity_vector();
+            prox_start.assign(ps.begin(), ps.end());
+            prox_end.assign(pe.begin(), pe.end());
+            meta = pipeline.get_meta_graph().get();
+        }
+        const std::vector<graph::_t_node_id>& nodes = meta->nodes;
+
+        // nodos
+        meta_dataset->add_node(start);
+        meta_dataset->add_node(end);
+        for (auto it = nodes.begin(); it != nodes.end(); ++it) {
+            meta_dataset->add_node(*it);
+            }
+
+        // edges
+        for (std::size_t i=0; i<nodes.size() && i<prox_start.size() && i<prox_end.size(); i++) {
+            if (prox_start[i]>0.f) {
+                meta_dataset->add_edge(start, nodes[i], 1-prox_start[i]);
+                if (log) (*log) << "\t\t " << start << " -> " << nodes[i] << " | cost= '" << 1-prox_start[i] << "'" << std::endl;
+                }
+            if (prox_end[i]>0.f) {
+                meta_dataset->add_edge(nodes[i], end, 1-prox_end[i]);
+                if (log) (*log) << "\t\t " << nodes[i] << " -> " << end << " | cost= '" << 1-prox_end[i] << "' <-- :S no garantizado!!" << std::endl;
+                }
+            }
+
+        // ... and the ones between colonies, already maintained by the pipeline
+        for (auto row = meta->rows.begin(); row != meta->rows.end(); ++row) {
+            for (auto it = (*row)->begin(); it != (*row)->end(); ++it) {
+                meta_dataset->add_edge(nodes[it->from], nodes[it->to], it->cost);
+                if (log) (*log) << "\t\t " << nodes[it->from] << " -> " << nodes[it->to] << " | cost= '" << it->cost << "'" << std::endl;
+                }
+            }
+        meta_graph.reset(new memgraph(*meta_dataset));
+        }
+
+    bool search_query::search_meta_path(unsigned int iterations) {
+        assert(meta_graph);
+        const config& cfg = pipeline.get_config();
+        AnCO::colony<algorithm::aco_mmas> metasearch_colony(*meta_graph, cfg.n_ants_per_colony, cfg.max_steps);
+        check_colony_id(metasearch_colony.get_id());
+        metasearch_colony.set_base_node(start);
+        pipeline_metrics& metrics = pipeline.get_metrics();
+        std::size_t n_succesful = meta_success.n_succesful, succesful_steps = meta_success.succesful_steps;
+        convergence_monitor monitor(pipeline.get_convergence());
+        std::size_t unique_paths = meta_success.hash_paths.inserted();
+        unsigned int iteration = 0;
+        while (++iteration < iterations) {
+            {
+                std::lock_guard<std::recursive_mutex> lock(library_rng_mutex()); // a search colony may be drawing
+                metasearch_colony.run(meta_success);
+            }
+            metasearch_colony.update();
+            colony_type::aco_algorithm_impl::update_graph(*meta_graph);
+            if (search_converged(monitor, meta_success, unique_paths)) {
+                ++iteration;
+                break;
+                }
+            }
+        if (iteration > 1) {
+            metrics.add_search(std::uint64_t(iteration-1)*cfg.n_ants_per_colony, meta_success.n_succesful - n_succesful, meta_success.succesful_steps - succesful_steps);
+            }
+        return !meta_success.succesful_paths.empty();
+        }
+
+    bool search_query::descend_meta_path(std::ostream* log) {
+        search_hierarchy* hierarchy = pipeline.get_hierarchy();
+        assert(hierarchy);
+        std::vector<float> prox_start, prox_end;
+        meta_graph_maintainer::_t_ptr meta;
+        {
+            std::lock_guard<std::mutex> lock(pipeline.get_mutex());
+            auto ps = start_colony.get_proximity_vector();
+            auto pe = end_colony.get_proximity_vector();
+            prox_start.assign(ps.begin(), ps.end());
+            prox_end.assign(pe.begin(), pe.end());
+            meta = pipeline.get_meta_graph().get();
+        }
+
+        // Colonies closest to start/end: the route goes between them
+        const std::size_t n = (std::min)(meta->nodes.size(), (std::min)(prox_start.size(), prox_end.size()));
+        if (n == 0) {
+            return false;
+            }
+        const std::size_t first = std::size_t(std::max_element(prox_start.begin(), prox_start.begin() + n) - prox_start.begin());
+        const std::size_t last = std::size_t(std::max_element(prox_end.begin(), prox_end.begin() + n) - prox_end.begin());
+        std::vector<graph::_t_node_id> route;
+        std::vector<float> costs;
+        if (prox_start[first] <= 0.f || prox_end[last] <= 0.f || !hierarchy->descend(meta->nodes[first], meta->nodes[last], route, costs)) {
+            return false;
+            }
+
+        // Meta-graph of the query: start -> route -> end
+        std::vector<graph::_t_node_id> hops(1, start);
+        std::vector<float> hop_costs;
+        auto add_hop = [&hops, &hop_costs](const graph::_t_node_id& node, float cost) {
+            if (node != hops.back()) {
+                hops.push_back(node);
+                hop_costs.push_back(cost);
+                }
+            };
+        add_hop(route.front(), 1-prox_start[first]);
+        for (std::size_t i = 1; i<route.size(); ++i) {
+            add_hop(route[i], costs[i-1]);
+            }
+        add_hop(end, 1-prox_end[last]);
+
+        meta_dataset.reset(new graph_data_file_builder());
+        std::set<graph::_t_node_id> added;
+        for (auto it = hops.begin(); it != hops.end(); ++it) {
+            if (added.insert(*it).second) {
+                meta_dataset->add_node(*it);
+                }
+            }
+        for (std::size_t i = 0; i+1<hops.size(); ++i) {
+            meta_dataset->add_edge(hops[i], hops[i+1], hop_costs[i]);
+            if (log) (*log) << "\t\t " << hops[i] << " -> " << hops[i+1] << " | cost= '" << hop_costs[i] << "'" << std::endl;
+            }
+        meta_graph.reset(new memgraph(*meta_dataset));
+
+        // ... walked once through 'meta_success', as if an ant had found it
+        const std::set<graph::_t_node_id> none;
+        std::vector<edge_ptr> out;
+        meta_success.new_ant();
+        for (std::size_t i = 0; i+1<hops.size(); ++i) {
+            out.clear();
+            algorithm::aco_base::get_feasible_edges(*meta_graph, hops[i], out, none);
+            auto e = std::find_if(out.begin(), out.end(), [&hops, i](const edge_ptr& ptr){ return ptr->end == hops[i+1]; });
+            if (e == out.end() || meta_success(*e)) {
+                break;
+                }
+            }
+        return !meta_success.succesful_paths.empty();
+        }
+
+    bool search_query::best_meta_path(std::vector<edge_ptr>& metapath, float& cost) const {
+        // 'succesful_paths' is ordered by cost (and length)
+        if (meta_success.succesful_paths.empty()) {
+            metapath.clear();
+            cost = (std::numeric_limits<float>::max)();
+            return false;
+            }
+        metapath = meta_success.succesful_paths.front();
+        cost = meta_success.costs.front();
+        return true;
+        }
+
+    unsigned int search_query::expected_length() const {
+        unsigned int max_length = 0;
+        for (auto it = meta_success.succesful_paths.begin(); it!=meta_success.succesful_paths.end(); ++it) {
+            max_length = (std::max)(int(max_length), int(it->size()*(pipeline.get_config().max_steps-1)*2)); // las colonias pueden haberse visto justo en sus extremos!
+            }
+        return max_length;
+        }
+
+    algorithm::objective_set::_t_ptr search_query::make_objectives(const std::vector<edge_ptr>& metapath) const {
+        std::vector<algorithm::objective_set::objective> objective_list;
+        float objective_price = 1/(float)metapath.size();
+        float sum_price = 0.f;
+        for (auto it = metapath.begin(); it!= metapath.end(); ++it) {
+            sum_price += objective_price;
+            auto slot = colony_slots.find((*it)->end);
+            assert(slot != colony_slots.end());
+            objective_list.push_back(algorithm::objective_set::objective((*it)->end, slot->second, sum_price));
+            }
+        return algorithm::objective_set::make(objective_list);
+        }
+
+    bool search_query::search_path(const std::vector<edge_ptr>& metapath, unsigned int iterations, std::vector<edge_ptr>& path, const std::function<void()>& on_iteration) {
+        const config& cfg = pipeline.get_config();
+        neighbourhood_type& colony_meta = pipeline.get_neighbourhood();
+        algorithm::objective_set::_t_ptr objectives = this->make_objectives(metapath);
+        algorithm::aco_multiobjetivo::objective_scope scope(objectives);
+        lazy_evaporation::scope evaporation_scope(pipeline.get_lazy_evaporation());
+        graph_index::scope index_scope(&pipeline.get_index());
+
+        search_colony_type search_colony(pipeline.get_graph(), cfg.n_ants_per_colony, this->expected_length());
+        check_colony_id(search_colony.get_id());
+        search_colony.set_base_node(start);
+        success_meta suc_multiobj(end);
+        pipeline_metrics& metrics = pipeline.get_metrics();
+        convergence_monitor monitor(pipeline.get_convergence());
+        std::size_t unique_paths = 0;
+        unsigned int iteration = 0;
+        while (++iteration < iterations) {
+            std::lock_guard<std::mutex> lock(pipeline.get_mutex());
+            std::size_t n_succesful = suc_multiobj.n_succesful, succesful_steps = suc_multiobj.succesful_steps;
+            {
+                pipeline_metrics::scoped_timer t(metrics, pipeline_metrics::phase_run);
+                parallel_run(pipeline.get_pool()).add(colony_meta).add(end_colony).add_task([&](){
+                    algorithm::aco_multiobjetivo::objective_scope scope(objectives);
+                    lazy_evaporation::scope evaporation_scope(pipeline.get_lazy_evaporation());
+                    graph_index::scope index_scope(&pipeline.get_index());
+                    search_colony.run(suc_multiobj);
+                    }).run();
+            }
+            {
+                pipeline_metrics::scoped_timer t(metrics, pipeline_metrics::phase_update);
+                colony_meta.update();
+                end_colony.update();
+                search_colony.update();
+                pipeline.update_meta_graph();
+            }
+            {
+                pipeline_metrics::scoped_timer t(metrics, pipeline_metrics::phase_evaporation);
+                pipeline.evaporate();
+            }
+            metrics.add_iteration();
+            metrics.add_ants(pipeline.ants_per_iteration() + cfg.n_ants_per_colony);
+            metrics.add_search(cfg.n_ants_per_colony, suc_multiobj.n_succesful - n_succesful, suc_multiobj.succesful_steps - succesful_steps);
+            if (on_iteration) {
+                on_iteration();
+                }
+            if (search_converged(monitor, suc_multiobj, unique_paths)) {
+                break;
+                }
+            }
+
+        path.clear();
+        if (!suc_multiobj.succesful_paths.empty()) {
+            path.swap(suc_multiobj.succesful_paths.front());
+            }
+        return !path.empty();
+        }
+
+    bool search_query::refine_path(const std::vector<edge_ptr>& metapath, std::vector<edge_ptr>& path) {
+        algorithm::objective_set::_t_ptr objectives = this->make_objectives(metapath);
+        std::vector<unsigned int> pherom_ids(1, start_colony.get_id());
+        for (auto it = objectives->begin(); it != objectives->end(); ++it) {
+            pherom_ids.push_back(it->pherom_id);
+            }
+        std::lock_guard<std::mutex> lock(pipeline.get_mutex());
+        lazy_evaporation::scope evaporation_scope(pipeline.get_lazy_evaporation());
+        return algorithm::corridor_path(pipeline.get_index(), start, end, pherom_ids, algorithm::pheromone_threshold, path);
+        }
+
+    bool search_query::race_paths(std::size_t n_candidates, unsigned int iterations, float max_cost,
+                                  std::vector<edge_ptr>& metapath, std::vector<edge_ptr>& path,
+                                  const std::function<void()>& on_iteration) {
+        // A path within the bound raises 'found' as soon as the ant reaches the end: the ants of every
+        //  candidate stop then ('aco_multiobjetivo::stop_scope'), not at the end of the iteration
+        struct race_success : success_meta {
+            race_success(const graph::_t_node_id& end, float max_cost, std::atomic<bool>& found) : success_meta(end), max_cost(max_cost), found(found) {};
+            virtual bool operator()(edge_ptr ptr) {
+                const bool ret = success_meta::operator()(ptr);
+                if (ret && tmp_cost <= max_cost) {
+                    found.store(true);
+                    }
+                return ret;
+                };
+            float max_cost;
+            std::atomic<bool>& found;
+            };
+
+        // One multi-objective colony (own pheromone slot) per candidate meta-path; all of them share the graph
+        struct candidate {
+            candidate(graph& g, unsigned int n_ants, unsigned int max_steps, const graph::_t_node_id& start, const graph::_t_node_id& end,
+                      const std::vector<edge_ptr>& metapath, algorithm::objective_set::_t_ptr objectives, const convergence_monitor::options& opts,
+                      float max_cost, std::atomic<bool>& found)
+                : metapath(&metapath), objectives(objectives), colony(g, n_ants, max_steps), success(end, max_cost, found), monitor(opts), unique_paths(0), n_succesful(0), succesful_steps(0), active(true) {
+                check_colony_id(colony.get_id());
+                colony.set_base_node(start);
+                };
+            const std::vector<edge_ptr>* metapath; // into 'meta_success', untouched while racing
+            algorithm::objective_set::_t_ptr objectives;
+            search_colony_type colony;
+            race_success success;
+            convergence_monitor monitor;
+            std::size_t unique_paths;
+            std::size_t n_succesful, succesful_steps; // already reported to the metrics
+            bool active;
+            };
+
+        const config& cfg = pipeline.get_config();
+        neighbourhood_type& colony_meta = pipeline.get_neighbourhood();
+        pipeline_metrics& metrics = pipeline.get_metrics();
+        std::vector<std::unique_ptr<candidate>> candidates;
+        std::atomic<bool> found(false);
+        for (std::size_t i = 0; i<meta_success.succesful_paths.size() && i<n_candidates; ++i) {
+            const std::vector<edge_ptr>& candidate_path = meta_success.succesful_paths[i];
+            candidates.emplace_back(new candidate(pipeline.get_graph(), cfg.n_ants_per_colony, this->expected_length(), start, end,
+                                                  candidate_path, this->make_objectives(candidate_path), pipeline.get_convergence(), max_cost, found));
+            }
+
+        std::size_t n_active = candidates.size();
+        bool winner = false;
+        unsigned int iteration = 0;
+        while (++iteration < iterations && n_active > 0 && !winner) {
+            std::lock_guard<std::mutex> lock(pipeline.get_mutex());
+            graph_index::scope index_scope(&pipeline.get_index());
+            {
+                pipeline_metrics::scoped_timer t(metrics, pipeline_metrics::phase_run);
+                parallel_run batch(pipeline.get_pool());
+                batch.add(colony_meta).add(end_colony);
+                for (auto it = candidates.begin(); it != candidates.end(); ++it) {
+                    candidate* c = it->get();
+                    if (c->active) {
+                        batch.add_task([this, c, &found](){
+                            algorithm::aco_multiobjetivo::objective_scope scope(c->objectives);
+                            algorithm::aco_multiobjetivo::stop_scope stop(&found);
+                            lazy_evaporation::scope evaporation_scope(pipeline.get_lazy_evaporation());
+                            graph_index::scope index_scope(&pipeline.get_index());
+                            c->colony.run(c->success);
+                            });
+                        }
+                    }
+                batch.run();
+            }
+            {
+                pipeline_metrics::scoped_timer t(metrics, pipeline_metrics::phase_update);
+                lazy_evaporation::scope evaporation_scope(pipeline.get_lazy_evaporation());
+                colony_meta.update();
+                end_colony.update();
+                for (auto it = candidates.begin(); it != candidates.end(); ++it) {
+                    if ((*it)->active) {
+                        algorithm::aco_multiobjetivo::objective_scope scope((*it)->objectives);
+                        (*it)->colony.update();
+                        }
+                    }
+                pipeline.update_meta_graph();
+            }
+            {
+                pipeline_metrics::scoped_timer t(metrics, pipeline_metrics::phase_evaporation);
+                pipeline.evaporate();
+            }
+            metrics.add_iteration();
+            metrics.add_ants(pipeline.ants_per_iteration() + std::uint64_t(n_active)*cfg.n_ants_per_colony);
+
+            // A path within the bound cancels every other candidate; converged candidates drop out of the race
+            for (auto it = candidates.begin(); it != candidates.end(); ++it) {
+                candidate& c = **it;
+                if (!c.active) {
+                    continue;
+                    }
+                std::size_t n_succesful = c.success.n_succesful, succesful_steps = c.success.succesful_steps;
+                metrics.add_search(cfg.n_ants_per_colony, n_succesful - c.n_succesful, succesful_steps - c.succesful_steps);
+                c.n_succesful = n_succesful;
+                c.succesful_steps = succesful_steps;
+                winner = winner || (!c.success.costs.empty() && c.success.costs.front() <= max_cost);
+                if (search_converged(c.monitor, c.success, c.unique_paths)) {
+                    c.active = false;
+                    --n_active;
+                    }
+                }
+            if (on_iteration) {
+                on_iteration();
+                }
+            }
+
+        // Cheapest path among all the candidates (cancelled ones included)
+        metapath.clear();
+        path.clear();
+        candidate* best = nullptr;
+        for (auto it = candidates.begin(); it != candidates.end(); ++it) {
+            const success_meta& s = (*it)->success;
+            if (!s.costs.empty() && (!best || s.costs.front() < best->success.costs.front())) {
+                best = it->get();
+                }
+            }
+        if (best) {
+            path.swap(best->success.succesful_paths.front());
+            metapath = *best->metapath;
+            }
+        return best != nullptr;
+        }
+
+    bool search_query::answer(std::vector<edge_ptr>& metapath, std::vector<edge_ptr>& path, bool refine, std::size_t portfolio, float portfolio_bound) {
+        const config& cfg = pipeline.get_config();
+        pipeline.get_metrics().add_query();
+        metapath.clear();
+        path.clear();
+        for (unsigned int iteration = 1; iteration < cfg.training_iterations; ++iteration) {
+            if (this->iterate()) {
+                break;
+                }
+            }
+        if (!this->reachable()) {
+            return false;
+            }
+        search_hierarchy* hierarchy = pipeline.get_hierarchy();
+        if (!hierarchy || !hierarchy->n_levels() || !this->descend_meta_path()) {
+            this->build_meta_graph();
+            this->search_meta_path(cfg.training_iterations);
+            }
+        float metapath_cost;
+        if (!this->best_meta_path(metapath, metapath_cost)) {
+            return false;
+            }
+        if (refine && this->refine_path(metapath, path)) {
+            return true;
+            }
+        if (portfolio > 1) {
+            return this->race_paths(portfolio, cfg.training_iterations+100, portfolio_bound, metapath, path);
+            }
+        return this->search_path(metapath, cfg.training_iterations+100, path);
+        }
+
+    float search_query::path_cost(const std::vector<edge_ptr>& path) {
+        return std::accumulate(path.begin(), path.end(), 0.f, [](float x, edge_ptr ptr){ return x + ptr->data.length;});
+        }
+
+    }
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <ostream>
+#include <unordered_map>
+#include <limits>
+
+#include "jgsogo/AnCO/config.h"
+#include "jgsogo/AnCO/graph/memgraph.h"
+#include "jgsogo/AnCO/graph/graph_data_file.h"
+#include "jgsogo/AnCO/algorithm/aco_base.h"
+#include "jgsogo/AnCO/algorithm/aco_random.h"
+#include "aco_random_streams.h"
+#include "jgsogo/AnCO/algorithm/aco_mmas.h"
+#include "jgsogo/AnCO/algorithm/prox_percent.h"
+#include "jgsogo/AnCO/colony/neighbourhood.h"
+
+#include "success_meta.h"
+#include "aco_multiobjetivo.h"
+#include "objective_set.h"
+#include "work_stealing_pool.h"
+#include "pipeline_metrics.h"
+#include "meta_graph.h"
+#include "lazy_evaporation.h"
+#include "convergence_monitor.h"
+#include "counter_rng.h"
+#include "graph_updates.h"
+#include "graph_index.h"
+
+namespace AnCO {
+
+    typedef algorithm::prox_percent prox_algorithm;
+    // Colonies that deposit on the graph settle its lazy evaporation first (see 'lazy_evaporation'); the
+    //  ants of the neighbourhood draw from their own streams (see 'aco_random_streams')
+    typedef settle_before_deposit<algorithm::aco_random_streams> aco_algorithm;
+    typedef AnCO::colony<settle_before_deposit<algorithm::aco_multiobjetivo>> search_colony_type;
+
+    typedef AnCO::colony<algorithm::aco_base> colony_type;
+
+    typedef AnCO::colony_neighbourhood<aco_algorithm, prox_algorithm> colony_neighbourhood_type;
+    typedef AnCO::neighbourhood<aco_algorithm, prox_algorithm> neighbourhood_type;
+
+    class search_hierarchy;
+
+    // A colony deposits in slot 'id' of the pheromone array of every edge: throws std::runtime_error
+    //  if that slot is past N_MAX_COLONIES (the library numbers colonies itself, so every place that
+    //  builds one checks it).
+    void check_colony_id(unsigned int id);
+
+    /*
+    The query-independent part of the search: the neighbourhood of colonies
+    trained over the graph. Every iteration that touches the pheromone of the
+    graph (this one's and the ones of the queries) is serialized through
+    'get_mutex()', so the neighbourhood can keep training in background while
+    queries are answered. The meta-graph of the neighbourhood is maintained
+    (in a thread of its own) after every update of its colonies, so queries
+    don't have to rebuild it.
+    */
+    class search_pipeline {
+        public:
+            search_pipeline(graph& graph, graph_index& index, const config& cfg, work_stealing_pool& pool);
+
+            // One training iteration of the neighbourhood: run, update and evaporation.
+            void iterate();
+            // True once the metric of every colony and the meta-graph have stopped changing (see 'set_convergence').
+            //  Safe without the mutex: the monitor is only read under it and its state is kept in an atomic.
+            bool converged() const { return training_converged.load(); };
+            // Changes to the live graph between iterations; training is no longer converged if any edge changed.
+            std::size_t apply_updates(const graph_updates& updates);
+            // Evaporation at the end of an iteration (caller holds the mutex): 'update_graph' or the lazy one.
+            void evaporate();
+            void set_lazy_evaporation(lazy_evaporation* e) { evaporation = e; };
+            // Hands the proximity of the neighbourhood to the meta-graph (caller holds the mutex); the library
+            //  computes it from the pheromone of the whole graph, so the lazy evaporation is compacted first.
+            std::size_t update_meta_graph();
+            lazy_evaporation* get_lazy_evaporation() { return evaporation; };
+            // Levels of colonies above this one (queries descend them instead of searching the flat meta-graph)
+            void set_hierarchy(search_hierarchy* h) { hierarchy = h; };
+            search_hierarchy* get_hierarchy() { return hierarchy; };
+            unsigned int get_iteration() const { return iteration; };
+            void set_iteration(unsigned int it) { iteration = it; };
+
+            // Called after every training iteration, with the mutex still held (checkpoints).
+            typedef std::function<void (search_pipeline&)> _f_listener;
+            void set_listener(const _f_listener& l) { listener = l; };
+
+            // Early termination of every phase (training, queries, meta-path and path searches).
+            void set_convergence(const convergence_monitor::options& opts) {
+                std::lock_guard<std::mutex> lock(mutex);
+                convergence = opts;
+                training = convergence_monitor(opts);
+                training_converged.store(false);
+                };
+            const convergence_monitor::options& get_convergence() const { return convergence; };
+
+            graph& get_graph() { return g; };
+            // Dense numbering of 'get_graph()' (install it with a 'graph_index::scope' where ants of this block run)
+            const graph_index& get_index() const { return index; };
+            const config& get_config() const { return cfg; };
+            work_stealing_pool& get_pool() { return pool; };
+            neighbourhood_type& get_neighbourhood() { return colony_meta; };
+            std::mutex& get_mutex() { return mutex; };
+            pipeline_metrics& get_metrics() { return metrics; };
+            meta_graph_maintainer& get_meta_graph() { return meta_graph; };
+
+            // Ants launched by every iteration of the neighbourhood.
+            std::uint64_t ants_per_iteration() const { return std::uint64_t(cfg.n_colonies)*cfg.n_ants_per_colony; };
+
+        protected:
+            graph& g;
+            graph_index& index;          // takes the edges inserted by 'apply_updates'
+            const config cfg;
+            work_stealing_pool& pool;
+            neighbourhood_type colony_meta;
+            unsigned int iteration;
+            std::mutex mutex;
+            _f_listener listener;
+            pipeline_metrics metrics;
+            meta_graph_maintainer meta_graph;
+            lazy_evaporation* evaporation;
+            search_hierarchy* hierarchy;
+            convergence_monitor::options convergence;
+            convergence_monitor training;
+            std::atomic<bool> training_converged;   // 'training.converged()', written under the mutex
+        };
+
+    /*
+    Everything that depends on one (start, end) pair: its own start/end
+    colonies, the meta-graph built over the trained neighbourhood, the MMAS
+    search for meta-paths and the multi-objective search in the original graph.
+    */
+    class search_query {
+        public:
+            search_query(search_pipeline& pipeline, const graph::_t_node_id& start, const graph::_t_node_id& end);
+
+            // 5) Train start/end colonies (together with the neighbourhood); returns true once converged
+            bool iterate();
+            bool reachable() const;
+
+            // 6) Meta-graph: the one maintained by the pipeline plus start/end nodes and their edges
+            void build_meta_graph(std::ostream* log = nullptr);
+
+            // 7) Search for meta-paths in the meta-graph (MMAS), up to 'iterations' or convergence
+            bool search_meta_path(unsigned int iterations);
+            // 6-7) ... or descend the hierarchy of the pipeline: the meta-graph is just the route found
+            bool descend_meta_path(std::ostream* log = nullptr);
+            bool best_meta_path(std::vector<edge_ptr>& metapath, float& cost) const;
+            unsigned int expected_length() const;
+
+            // 8) Search for the actual path in the original graph following a meta-path (up to 'iterations' or convergence)
+            algorithm::objective_set::_t_ptr make_objectives(const std::vector<edge_ptr>& metapath) const;
+            bool search_path(const std::vector<edge_ptr>& metapath, unsigned int iterations, std::vector<edge_ptr>& path, const std::function<void()>& on_iteration = std::function<void()>());
+            // ... or the shortest path inside the corridor of the meta-path colonies (see 'corridor_path')
+            bool refine_path(const std::vector<edge_ptr>& metapath, std::vector<edge_ptr>& path);
+            // ... or race the 'n_candidates' best meta-paths concurrently: as soon as one of them finds a path
+            //  with 'cost <= max_cost' the others are cancelled; 'metapath' and 'path' are the cheapest result
+            bool race_paths(std::size_t n_candidates, unsigned int iterations, float max_cost,
+                            std::vector<edge_ptr>& metapath, std::vector<edge_ptr>& path,
+                            const std::function<void()>& on_iteration = std::function<void()>());
+
+            // 5-8) All the steps with the configured number of iterations, following the best meta-path
+            //  ('refine': try the corridor first and only search with ants if there is no path in it;
+            //   'portfolio > 1': race that many meta-paths instead of following only the best one, until
+            //   one finds a path with 'cost <= portfolio_bound' (the first path found by default);
+            //   with a hierarchy, the meta-path is the route that descends it when there is one)
+            bool answer(std::vector<edge_ptr>& metapath, std::vector<edge_ptr>& path, bool refine = false, std::size_t portfolio = 1,
+                        float portfolio_bound = (std::numeric_limits<float>::max)());
+
+            colony_neighbourhood_type& get_start_colony() { return start_colony; };
+            colony_neighbourhood_type& get_end_colony() { return end_colony; };
+            const success_meta& get_meta_success() const { return meta_success; };
+
+            static float path_cost(const std::vector<edge_ptr>& path);
+
+        protected:
+            search_pipeline& pipeline;
+            graph::_t_node_id start, end;
+            colony_neighbourhood_type start_colony;
+            colony_neighbourhood_type end_colony;
+
+            std::unique_ptr<graph_data_file_builder> meta_dataset;
+            std::unique_ptr<memgraph> meta_graph;
+            success_meta meta_success;
+            convergence_monitor training;
+            std::unordered_map<graph::_t_node_id, unsigned int> colony_slots; // base node -> pheromone id (built once per query)
+        };
+
+    }
@@ -0,0 +1,53 @@
+/**
+ * Convert a text graph dataset into a binary snapshot
+ *
+ * @file snapshot_converter.cpp
+ * @section LICENSE
+
+    This code is under MIT License, http://opensource.org/licenses/MIT
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+
+#include "jgsogo/AnCO/graph/graph_data_file.h"
+#include "jgsogo/AnCO/graph/memgraph.h"
+
+#include "graph_snapshot.h"
+
+using namespace AnCO;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " 'GRAPH_DATASET' ['SNAPSHOT_FILE'] [--no-check]" << std::endl;
+        return 1;
+        }
+    std::string dataset = argv[1];
+    std::string snapshot_file = (argc > 2 && std::strcmp(argv[2], "--no-check") != 0) ? argv[2] : dataset + ".snapshot";
+    const bool check = std::strcmp(argv[argc-1], "--no-check") != 0;
+    try {
+        graph_snapshot::convert(dataset, snapshot_file);
+        graph_snapshot snapshot;
+        snapshot.open(snapshot_file);
+        std::cout << snapshot_file << ": " << snapshot.n_nodes() << " nodes, " << snapshot.n_edges() << " edges" << std::endl;
+
+        if (check) {
+            // Parity with the parser of the library: same edges (and lengths) out of every node
+            graph_data_file data(dataset);
+            data.load_file();
+            memgraph graph(data);
+            const std::size_t mismatches = snapshot.check(graph);
+            if (mismatches) {
+                std::cerr << snapshot_file << ": " << mismatches << " nodes differ from '" << dataset << "' as read by graph_data_file" << std::endl;
+                return 1;
+                }
+            std::cout << snapshot_file << ": matches graph_data_file" << std::endl;
+            }
+        }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+        }
+    return 0;
+    }
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+namespace AnCO {
+
+    /*
+    Proximity between colonies keeping only the 'k' closest neighbours of
+    each one (those above 'threshold'): memory and every walk over it grow
+    with 'n_colonies * k' instead of 'n_colonies^2'.
+
+    Rows are stored with a fixed stride of 'k' entries ordered by column.
+    'update_row' takes a dense row (as given by the neighbourhood) and only
+    rewrites the stored one if an entry appears, disappears or moves more
+    than 'epsilon'. What is stored is sparse, what comes in is not: the
+    library computes the proximity as a dense matrix, so every update still
+    reads 'n_colonies^2' values (see 'meta_graph_maintainer::update'), and
+    the number of colonies is still bounded by N_MAX_COLONIES (one
+    pheromone slot per colony on every edge).
+    */
+    class sparse_proximity {
+        public:
+            struct entry {
+                std::uint32_t col;
+                float value;
+                };
+
+            sparse_proximity(std::size_t k = 16, float threshold = 0.f) : k(k), threshold(threshold), total(0) {};
+
+            void resize(std::size_t n_rows) {
+                entries.assign(n_rows*k, entry());
+                counts.assign(n_rows, 0);
+                total = 0;
+                };
+
+            std::size_t n_rows() const { return counts.size(); };
+            std::size_t max_neighbours() const { return k; };
+            float get_threshold() const { return threshold; };
+            std::size_t n_entries() const { return total; };
+            const entry* begin(std::size_t row) const { return &entries[row*k]; };
+            const entry* end(std::size_t row) const { return &entries[row*k] + counts[row]; };
+
+            // Returns the number of entries added, removed or re-weighted.
+            template <class row_t>
+            std::size_t update_row(std::size_t row, const row_t& values, std::size_t n, float epsilon) {
+                candidates.clear();
+                for (std::size_t j = 0; j<n; ++j) {
+                    if (j != row && values[j] > threshold) {
+                        entry e = {std::uint32_t(j), float(values[j])};
+                        candidates.push_back(e);
+                        }
+                    }
+                return this->assign(row, epsilon);
+                };
+
+            // Restores a row (top-k of the given entries).
+            std::size_t set_row(std::size_t row, const entry* first, const entry* last) {
+                candidates.assign(first, last);
+                return this->assign(row, 0.f);
+                };
+
+        protected:
+            std::size_t assign(std::size_t row, float epsilon) {
+                if (candidates.size() > k) {
+                    std::nth_element(candidates.begin(), candidates.begin() + k, candidates.end(), [](const entry& lhs, const entry& rhs){ return lhs.value > rhs.value; });
+                    candidates.resize(k);
+                    }
+                std::sort(candidates.begin(), candidates.end(), [](const entry& lhs, const entry& rhs){ return lhs.col < rhs.col; });
+
+                // Compare with the stored row (both ordered by column)
+                entry* stored = &entries[row*k];
+                const std::size_t n_stored = counts[row];
+                std::size_t changes = 0, i = 0, j = 0;
+                while (i < n_stored || j < candidates.size()) {
+                    if (j == candidates.size() || (i < n_stored && stored[i].col < candidates[j].col)) {
+                        ++changes; ++i;
+                        }
+                    else if (i == n_stored || candidates[j].col < stored[i].col) {
+                        ++changes; ++j;
+                        }
+                    else {
+                        changes += (std::fabs(stored[i].value - candidates[j].value) > epsilon) ? 1 : 0;
+                        ++i; ++j;
+                        }
+                    }
+                if (changes) {
+                    std::copy(candidates.begin(), candidates.end(), stored);
+                    total = total - n_stored + candidates.size();
+                    counts[row] = std::uint32_t(candidates.size());
+                    }
+                return changes;
+                };
+
+            std::size_t k;
+            float threshold;
+            std::vector<entry> entries;         // n_rows x k
+            std::vector<std::uint32_t> counts;
+            std::size_t total;
+            std::vector<entry> candidates;
+        };
+
+    }
@@ -1,37 +1,85 @@
-
 #pragma once
 
+#include <functional>
+#include <algorithm>
+
 #include "jgsogo/AnCO/colony/success.h"
 #include "jgsogo/AnCO/graph/graph.h"
+#include "fingerprint_set.h"
 
 using namespace AnCO;
 
+/*
+    Records the paths that reach 'id'. Each path is identified by a 64-bit
+    fingerprint computed while the ant walks (no strings, no I/O) and only the
+    'max_paths' cheapest unique paths are kept in 'succesful_paths', ordered by
+    cost (and length on ties). Fingerprints are remembered in a bounded window
+    ('fingerprint_window'); the ones of the kept paths are checked as well, so
+    no path is in the top-K twice.
+*/
 struct success_meta : success_node_found {
-    success_meta(_t_graph::_t_node_id id) : AnCO::success_node_found(id) {};
-    success_meta(success_meta& other) : success_node_found(other.id) {};
-    virtual void new_ant() { tmp.clear();};
+    success_meta(_t_graph::_t_node_id id, std::size_t max_paths = 16) : AnCO::success_node_found(id), max_paths(max_paths), n_succesful(0), succesful_steps(0) { succesful_paths.reserve(max_paths); costs.reserve(max_paths); fingerprints.reserve(max_paths); this->new_ant(); };
+    success_meta(success_meta& other) : success_node_found(other.id), max_paths(other.max_paths), n_succesful(0), succesful_steps(0) { succesful_paths.reserve(max_paths); costs.reserve(max_paths); fingerprints.reserve(max_paths); this->new_ant(); };
+    virtual void new_ant() { tmp.clear(); tmp_fingerprint = 0; tmp_cost = 0.f;};
     virtual bool operator()(edge_ptr ptr) {
+        if (tmp.empty()) {
+            tmp_fingerprint = fingerprint_mix(tmp_fingerprint, std::hash<_t_graph::_t_node_id>()(ptr->init));
+            }
         tmp.push_back(ptr);
+        tmp_fingerprint = fingerprint_mix(tmp_fingerprint, std::hash<_t_graph::_t_node_id>()(ptr->end));
+        tmp_cost += ptr->data.length;
         bool ret = (ptr->end == id);
         if (ret) {
-            add_to_succesful(tmp);
+            add_to_succesful(tmp, tmp_fingerprint, tmp_cost);
             }
         return ret;
         };
 
-    void add_to_succesful(std::vector<edge_ptr>& path) {
-        // compute hash
-        std::string hash = std::accumulate(path.begin(), path.end(), (*path.begin())->init, [](std::string x, edge_ptr ptr){ return x+ptr->end;});
-        std::cout << hash << std::endl;
-        std::set<std::string>::iterator it; bool inserted;
-        std::tie(it, inserted) = hash_paths.insert(hash);
-        if (inserted) {
-            succesful_paths.push_back(path);
+    void add_to_succesful(const std::vector<edge_ptr>& path, std::uint64_t fingerprint, float cost) {
+        ++n_succesful;
+        succesful_steps += path.size();
+        if (!hash_paths.insert(fingerprint) || std::find(fingerprints.begin(), fingerprints.end(), fingerprint) != fingerprints.end()) {
+            return;
+            }
+        auto worse = [](float cost, std::size_t size, const std::pair<float, std::size_t>& other) {
+            return (cost > other.first) || ((cost == other.first) && (size >= other.second));
+            };
+        if (succesful_paths.size() == max_paths && worse(cost, path.size(), std::make_pair(costs.back(), succesful_paths.back().size()))) {
+            return;
+            }
+        // Position in the top-K (ordered by cost, then length)
+        std::size_t pos = 0;
+        while (pos < succesful_paths.size() && worse(cost, path.size(), std::make_pair(costs[pos], succesful_paths[pos].size()))) {
+            ++pos;
             }
+        if (succesful_paths.size() == max_paths) {
+            // Reuse the storage of the evicted path
+            std::vector<edge_ptr> evicted;
+            evicted.swap(succesful_paths.back());
+            succesful_paths.pop_back();
+            costs.pop_back();
+            fingerprints.pop_back();
+            evicted.assign(path.begin(), path.end());
+            succesful_paths.insert(succesful_paths.begin() + pos, std::vector<edge_ptr>());
+            succesful_paths[pos].swap(evicted);
+            }
+        else {
+            succesful_paths.insert(succesful_paths.begin() + pos, path);
+            }
+        costs.insert(costs.begin() + pos, cost);
+        fingerprints.insert(fingerprints.begin() + pos, fingerprint);
         };
 
+    std::size_t max_paths;
+    std::size_t n_succesful;                            // successful ants (including repeated paths)
+    std::size_t succesful_steps;                        // sum of their lengths
+
     std::vector<edge_ptr> tmp;
-    
-    std::set<std::string> hash_paths;
-    std::vector<std::vector<edge_ptr>> succesful_paths;
-    };
\ No newline at end of file
+    std::uint64_t tmp_fingerprint;
+    float tmp_cost;
+
+    fingerprint_window hash_paths;                      // unique paths found recently ('inserted()': all of them)
+    std::vector<std::vector<edge_ptr>> succesful_paths; // top 'max_paths', cheapest first
+    std::vector<float> costs;
+    std::vector<std::uint64_t> fingerprints;
+    };
@@ -0,0 +1,98 @@
+/**
+ * Walks of 'aco_random_streams' colonies replayed with different numbers of threads
+ *
+ * @file aco_streams_test.cpp
+ * @section LICENSE
+
+    This code is under MIT License, http://opensource.org/licenses/MIT
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+
+#include "jgsogo/AnCO/colony/success.h"
+#include "jgsogo/AnCO/graph/memgraph.h"
+
+#include "../aco_random_streams.h"
+#include "../counter_rng.h"
+#include "../graph_generators.h"
+#include "../graph_snapshot.h"
+#include "../graph_index.h"
+#include "../work_stealing_pool.h"
+
+using namespace AnCO;
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+        }
+    }
+
+const unsigned int n_colonies = 8;
+const unsigned int n_ants = 20;
+const int max_steps = 60;
+
+// Every colony is a task that launches its ants in order, as 'colony::run' does; paths[colony*n_ants + ant]
+std::vector<std::vector<edge_ptr>> walk(graph& graph, const graph_snapshot& snapshot, const graph_index* index, unsigned int n_threads, std::uint64_t seed) {
+    work_stealing_pool pool(n_threads);
+    random_streams::seed(seed);
+    std::vector<std::vector<edge_ptr>> paths(n_colonies*n_ants);
+    std::vector<work_stealing_pool::_t_task> tasks;
+    for (unsigned int c = 0; c<n_colonies; ++c) {
+        tasks.push_back([&, c](){
+            graph_index::scope index_scope(index);
+            const graph::_t_node_id start = snapshot.node_id(graph_snapshot::_t_index(c));
+            success_node_found suc(snapshot.node_id(graph_snapshot::_t_index(snapshot.n_nodes()-1)));
+            for (unsigned int a = 0; a<n_ants; ++a) {
+                suc.new_ant();
+                algorithm::aco_random_streams::run(graph, start, c, suc, paths[c*n_ants + a], max_steps);
+                }
+            });
+        }
+    pool.run(tasks);
+    return paths;
+    }
+
+int main() {
+    const std::string filename = "aco_streams_test.snapshot";
+    {
+        graph_snapshot_writer writer;
+        generators::_t_rng rng(17);
+        generators::grid(writer, 400, rng);
+        writer.write(filename);
+    }
+    graph_snapshot snapshot;
+    snapshot.open(filename);
+    std::unique_ptr<memgraph> graph = snapshot.make_graph();
+    graph_index index(snapshot, *graph);
+
+    // With the index of the graph and without it (walk over the edges of the library)
+    const graph_index* indexes[] = {&index, nullptr};
+    for (auto it = std::begin(indexes); it != std::end(indexes); ++it) {
+        const std::string with = *it ? " (graph_index)" : " (library edges)";
+        std::vector<std::vector<edge_ptr>> one = walk(*graph, snapshot, *it, 1, 42);
+        std::vector<std::vector<edge_ptr>> four = walk(*graph, snapshot, *it, 4, 42);
+        std::vector<std::vector<edge_ptr>> again = walk(*graph, snapshot, *it, 4, 42);
+        std::vector<std::vector<edge_ptr>> other = walk(*graph, snapshot, *it, 4, 43);
+
+        std::size_t steps = 0;
+        for (auto path = one.begin(); path != one.end(); ++path) {
+            steps += path->size();
+            }
+        check(steps > 0, "ants walk" + with);
+        check(one == four, "same paths with 1 and 4 threads" + with);
+        check(four == again, "same paths when the seed is set again" + with);
+        check(one != other, "another seed, other paths" + with);
+        }
+
+    snapshot.close();
+    std::remove(filename.c_str());
+    std::cout << (failures ? "FAILED" : "OK") << std::endl;
+    return failures ? 1 : 0;
+    }
@@ -0,0 +1,115 @@
+/**
+ * Round-trip and comparison of the pheromone records kept by checkpoints
+ *
+ * @file checkpoint_pheromone_test.cpp
+ * @section LICENSE
+
+    This code is under MIT License, http://opensource.org/licenses/MIT
+ */
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <random>
+#include <cstring>
+
+#include "../checkpoint_pheromone.h"
+
+using namespace AnCO;
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+        }
+    }
+
+bool same_dense(const std::vector<float>& lhs, const std::vector<float>& rhs) {
+    return std::memcmp(lhs.data(), rhs.data(), lhs.size()*sizeof(float)) == 0;
+    }
+
+int main() {
+    const std::size_t n_slots = 100;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<std::size_t> slot(0, n_slots-1);
+
+    // Edges from untouched to dense (inline and overflow records), with and without a majority value
+    std::vector<std::vector<float>> edges;
+    for (std::size_t touched = 0; touched<=n_slots; touched += (touched < 8 ? 1 : 23)) {
+        std::vector<float> values(n_slots, 0.f);
+        for (std::size_t i = 0; i<touched; ++i) {
+            values[slot(rng)] = float(rng() % 7) + 0.5f;
+            }
+        edges.push_back(values);
+        }
+    std::vector<float> halves(n_slots, 1.f);
+    std::fill(halves.begin(), halves.begin() + n_slots/2, 2.f);
+    edges.push_back(halves);
+    std::vector<float> signed_zero(n_slots, 0.f);
+    signed_zero[3] = -0.f;
+    edges.push_back(signed_zero);
+
+    checkpoint_pheromone store(n_slots), copy(n_slots), loaded(n_slots);
+    store.resize(edges.size());
+    copy.resize(edges.size());
+    loaded.resize(edges.size());
+    std::stringstream file;
+    for (std::size_t e = 0; e<edges.size(); ++e) {
+        store.set(e, edges[e].data());
+        copy.copy(e, store, e);
+        store.write(file, e);
+        }
+    std::vector<float> dense(n_slots);
+    for (std::size_t e = 0; e<edges.size(); ++e) {
+        store.get(e, dense.data());
+        check(same_dense(dense, edges[e]), "get(set(x)) == x, edge " + std::to_string(e));
+        for (std::size_t s = 0; s<n_slots; ++s) {
+            check(store.get(e, s) == edges[e][s], "get(e, slot), edge " + std::to_string(e));
+            }
+        check(loaded.read(file, e), "read, edge " + std::to_string(e));
+        loaded.get(e, dense.data());
+        check(same_dense(dense, edges[e]), "read(write(x)) == x, edge " + std::to_string(e));
+        check(store.same(e, loaded, e) && store.same(e, copy, e), "same() after round-trip, edge " + std::to_string(e));
+        }
+    check(store.record_bytes(0) == 8, "untouched edge is only its base and count");
+
+    // The base is the most frequent value even without a majority (a majority vote alone would
+    //  end with 2.f here): 40 zeros, 30 ones and 30 twos leave 60 slots to store
+    std::vector<float> plurality(n_slots);
+    for (std::size_t i = 0; i<n_slots; ++i) {
+        plurality[i] = (i < 40) ? 0.f : ((i % 2) ? 1.f : 2.f);
+        }
+    checkpoint_pheromone mode(n_slots);
+    mode.resize(1);
+    mode.set(0, plurality.data());
+    check(mode.record_bytes(0) == 8 + 60*6, "base is the most frequent value");
+
+    // Canonical: the same values in another order of writes give the same record
+    checkpoint_pheromone other(n_slots);
+    other.resize(1);
+    std::vector<float> reversed(halves.rbegin(), halves.rend());
+    other.set(0, reversed.data());
+    other.set(0, halves.data());
+    check(other.same(0, store, edges.size()-2), "same() for equal values");
+    other.set(0, signed_zero.data());
+    check(other.same(0, store, edges.size()-1), "same() for -0.f");
+    check(!other.same(0, store, 0), "!same() for different values");
+
+    // Truncated and out of range records are rejected
+    std::stringstream truncated(file.str().substr(0, 6));
+    check(!loaded.read(truncated, 0), "truncated record");
+    std::stringstream bad;
+    const float base = 0.f;
+    const std::uint32_t count = 1;
+    const std::uint16_t bad_slot = std::uint16_t(n_slots);
+    bad.write(reinterpret_cast<const char*>(&base), sizeof(float));
+    bad.write(reinterpret_cast<const char*>(&count), sizeof(std::uint32_t));
+    bad.write(reinterpret_cast<const char*>(&bad_slot), sizeof(std::uint16_t));
+    bad.write(reinterpret_cast<const char*>(&base), sizeof(float));
+    check(!loaded.read(bad, 0), "slot out of range");
+
+    std::cout << (failures ? "FAILED" : "OK") << std::endl;
+    return failures ? 1 : 0;
+    }
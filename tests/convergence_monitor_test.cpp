@@ -0,0 +1,116 @@
+/**
+ * Window and tolerance of the convergence monitor used to stop training phases
+ *
+ * @file convergence_monitor_test.cpp
+ * @section LICENSE
+
+    This code is under MIT License, http://opensource.org/licenses/MIT
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../convergence_monitor.h"
+
+using namespace AnCO;
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+        }
+    }
+
+// Iteration (1-based) at which 'monitor' reports convergence on 'values', 0 if it never does
+std::size_t converges_at(convergence_monitor& monitor, const std::vector<double>& values) {
+    for (std::size_t i = 0; i<values.size(); ++i) {
+        if (monitor.add(values[i])) {
+            return i+1;
+            }
+        }
+    return 0;
+    }
+
+int main() {
+    const std::vector<double> flat(20, 5.);
+
+    // Window 0 disables it, whatever the signals
+    {
+        convergence_monitor monitor;
+        check(converges_at(monitor, flat) == 0, "window 0 never converges");
+        check(!monitor.converged(), "window 0 is not converged");
+    }
+
+    // A constant signal converges as soon as the window is full, not before
+    {
+        convergence_monitor monitor(convergence_monitor::options(4, 0.01));
+        check(converges_at(monitor, flat) == 4, "constant signal converges when the window is full");
+        check(monitor.converged(), "converged() after add() returned true");
+    }
+
+    // Tolerance is relative to the magnitude of the signal...
+    {
+        std::vector<double> values;
+        for (std::size_t i = 0; i<20; ++i) {
+            values.push_back(1000. + ((i%2) ? 5. : 0.)); // oscillates 0.5%
+            }
+        convergence_monitor within(convergence_monitor::options(3, 0.01));
+        check(converges_at(within, values) == 3, "0.5% oscillation is within 1%");
+        convergence_monitor outside(convergence_monitor::options(3, 0.001));
+        check(converges_at(outside, values) == 0, "0.5% oscillation is outside 0.1%");
+    }
+
+    // ...and absolute below 1
+    {
+        std::vector<double> values;
+        for (std::size_t i = 0; i<20; ++i) {
+            values.push_back((i%2) ? 0.005 : 0.);
+            }
+        convergence_monitor monitor(convergence_monitor::options(3, 0.01));
+        check(converges_at(monitor, values) == 3, "small signal compared in absolute terms");
+    }
+
+    // Only the last 'window' iterations count: a decreasing signal converges once it flattens
+    {
+        std::vector<double> values;
+        for (std::size_t i = 0; i<10; ++i) {
+            values.push_back(100. - 10.*i);
+            }
+        values.resize(20, values.back());
+        convergence_monitor monitor(convergence_monitor::options(5, 0.01));
+        check(converges_at(monitor, values) == 14, "converges 'window' iterations after the signal flattens");
+    }
+
+    // Every signal has to be stable
+    {
+        convergence_monitor monitor(convergence_monitor::options(3, 0.01));
+        bool converged = false;
+        for (std::size_t i = 0; i<10 && !converged; ++i) {
+            std::vector<double> values;
+            values.push_back(5.);
+            values.push_back(double(i));
+            converged = monitor.add(values);
+            }
+        check(!converged, "one moving signal keeps the phase running");
+    }
+
+    // A new set of signals (more colonies) and 'reset' start the window over
+    {
+        convergence_monitor monitor(convergence_monitor::options(3, 0.01));
+        monitor.add(1.);
+        monitor.add(1.);
+        check(!monitor.add(std::vector<double>(2, 1.)), "different number of signals starts over");
+        check(!monitor.add(std::vector<double>(2, 1.)), "different number of signals starts over (2)");
+        check(monitor.add(std::vector<double>(2, 1.)), "full window after the change");
+
+        monitor.reset();
+        check(!monitor.converged(), "reset clears convergence");
+        check(!monitor.add(std::vector<double>(2, 1.)), "reset empties the window");
+    }
+
+    std::cout << (failures ? "FAILED" : "OK") << std::endl;
+    return failures ? 1 : 0;
+    }
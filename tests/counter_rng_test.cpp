@@ -0,0 +1,116 @@
+/**
+ * Known-answer vectors of Philox4x32-10 and replay of counter-based streams
+ *
+ * @file counter_rng_test.cpp
+ * @section LICENSE
+
+    This code is under MIT License, http://opensource.org/licenses/MIT
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "../counter_rng.h"
+
+using namespace AnCO;
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+        }
+    }
+
+void check_philox(const std::uint32_t ctr[4], const std::uint32_t key[2], const std::uint32_t expected[4], const std::string& what) {
+    std::uint32_t out[4];
+    counter_rng::philox(ctr, key, out);
+    check(out[0] == expected[0] && out[1] == expected[1] && out[2] == expected[2] && out[3] == expected[3], what);
+    }
+
+int main() {
+    // Known-answer vectors of the reference implementation (Random123, kat_vectors: philox4x32 10 rounds)
+    {
+        const std::uint32_t ctr[4] = {0, 0, 0, 0}, key[2] = {0, 0};
+        const std::uint32_t expected[4] = {0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u};
+        check_philox(ctr, key, expected, "philox4x32-10, zeros");
+    }
+    {
+        const std::uint32_t ctr[4] = {0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu}, key[2] = {0xffffffffu, 0xffffffffu};
+        const std::uint32_t expected[4] = {0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu};
+        check_philox(ctr, key, expected, "philox4x32-10, all ones");
+    }
+    {
+        const std::uint32_t ctr[4] = {0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u}, key[2] = {0xa4093822u, 0x299f31d0u};
+        const std::uint32_t expected[4] = {0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u};
+        check_philox(ctr, key, expected, "philox4x32-10, digits of pi");
+    }
+
+    // The stream is (key = seed, counter = stream, ant, step, block): the first block of a step is philox of that counter
+    {
+        const std::uint64_t seed = 0x299f31d0a4093822ULL;
+        counter_rng rng(seed, 7, 3);
+        rng.at(11);
+        const std::uint32_t ctr[4] = {7, 3, 11, 0}, key[2] = {0xa4093822u, 0x299f31d0u};
+        std::uint32_t block[4];
+        counter_rng::philox(ctr, key, block);
+        bool same = true;
+        for (int i = 0; i<4; ++i) {
+            same = same && (rng.next() == block[i]);
+            }
+        check(same, "stream draws the philox block of (stream, ant, step, 0)");
+    }
+
+    // A step is replayed on its own, whatever was drawn before
+    {
+        counter_rng a(42, 1, 5), b(42, 1, 5);
+        a.at(9);
+        std::vector<std::uint32_t> first;
+        for (int i = 0; i<10; ++i) {
+            first.push_back(a.next());
+            }
+        for (int i = 0; i<37; ++i) {
+            b.next();
+            }
+        b.at(9);
+        bool same = true;
+        for (int i = 0; i<10; ++i) {
+            same = same && (b.next() == first[i]);
+            }
+        check(same, "at(step) replays the step");
+
+        counter_rng c(43, 1, 5), d(42, 2, 5);
+        c.at(9);
+        d.at(9);
+        check(c.next() != first[0], "other seed, other numbers");
+        check(d.next() != first[0], "other stream, other numbers");
+    }
+
+    // Ranges
+    {
+        counter_rng rng(1, 2, 3);
+        bool in_range = true;
+        std::vector<std::size_t> hits(7, 0);
+        for (int i = 0; i<70000; ++i) {
+            const float u = rng.uniform();
+            in_range = in_range && (u >= 0.f) && (u < 1.f);
+            const std::uint32_t k = rng.below(7);
+            in_range = in_range && (k < 7);
+            if (k < 7) {
+                ++hits[k];
+                }
+            }
+        check(in_range, "uniform() in [0, 1) and below(n) in [0, n)");
+        bool balanced = true;
+        for (std::size_t k = 0; k<hits.size(); ++k) {
+            balanced = balanced && (hits[k] > 9000) && (hits[k] < 11000);
+            }
+        check(balanced, "below(n) covers [0, n) evenly");
+    }
+
+    std::cout << (failures ? "FAILED" : "OK") << std::endl;
+    return failures ? 1 : 0;
+    }
@@ -0,0 +1,109 @@
+/**
+ * Ants of the neighbourhood ('aco_random_streams' with the graph index) after edges are inserted and removed
+ *
+ * @file graph_updates_test.cpp
+ * @section LICENSE
+
+    This code is under MIT License, http://opensource.org/licenses/MIT
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+
+#include "jgsogo/AnCO/colony/success.h"
+#include "jgsogo/AnCO/graph/memgraph.h"
+
+#include "../aco_random_streams.h"
+#include "../counter_rng.h"
+#include "../graph_snapshot.h"
+#include "../graph_index.h"
+#include "../graph_updates.h"
+
+using namespace AnCO;
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+        }
+    }
+
+const unsigned int n_ants = 64;
+
+// Ants of one colony from '0' to '4'
+std::vector<std::vector<edge_ptr>> walk(graph& graph) {
+    std::vector<std::vector<edge_ptr>> paths(n_ants);
+    success_node_found suc("4");
+    for (unsigned int a = 0; a<n_ants; ++a) {
+        suc.new_ant();
+        algorithm::aco_random_streams::run(graph, "0", 0, suc, paths[a], 10);
+        }
+    return paths;
+    }
+
+bool takes(const std::vector<edge_ptr>& path, const std::string& init, const std::string& end) {
+    for (auto it = path.begin(); it != path.end(); ++it) {
+        if ((*it)->init == init && (*it)->end == end) {
+            return true;
+            }
+        }
+    return false;
+    }
+
+std::size_t count(const std::vector<std::vector<edge_ptr>>& paths, const std::string& init, const std::string& end) {
+    std::size_t n = 0;
+    for (auto it = paths.begin(); it != paths.end(); ++it) {
+        n += takes(*it, init, end) ? 1 : 0;
+        }
+    return n;
+    }
+
+int main() {
+    // 0 -> 1 -> 2 -> 3 -> 4, and 0 -> 5 -> 4
+    const std::string filename = "graph_updates_test.snapshot";
+    {
+        graph_snapshot_writer writer;
+        writer.add_edge("0", "1", 1.f);
+        writer.add_edge("1", "2", 1.f);
+        writer.add_edge("2", "3", 1.f);
+        writer.add_edge("3", "4", 1.f);
+        writer.add_edge("0", "5", 1.f);
+        writer.add_edge("5", "4", 1.f);
+        writer.write(filename);
+    }
+    graph_snapshot snapshot;
+    snapshot.open(filename);
+    std::unique_ptr<memgraph> graph = snapshot.make_graph();
+    graph_index index(snapshot, *graph);
+    graph_index::scope index_scope(&index);
+    random_streams::seed(7);
+
+    std::vector<std::vector<edge_ptr>> before = walk(*graph);
+    check(count(before, "0", "5") > 0 && count(before, "0", "1") > 0, "both branches are walked");
+    check(count(before, "0", "4") == 0, "no shortcut yet");
+
+    // Shortcut 0 -> 4 (only in the index) and 0 -> 5 removed
+    graph_updates updates;
+    updates.insert("0", "4", 0.5f);
+    updates.remove("0", "5");
+    check(updates.apply(*graph, &index) == 2, "one edge inserted, one removed");
+
+    std::vector<std::vector<edge_ptr>> after = walk(*graph);
+    check(count(after, "0", "4") > 0, "the inserted shortcut is walked");
+    check(count(after, "0", "5") == 0, "the removed edge is not walked");
+    bool shortcut = false;
+    for (auto it = after.begin(); it != after.end(); ++it) {
+        shortcut = shortcut || (it->size() == 1 && takes(*it, "0", "4"));
+        }
+    check(shortcut, "an ant reaches the end through the shortcut");
+
+    snapshot.close();
+    std::remove(filename.c_str());
+    std::cout << (failures ? "FAILED" : "OK") << std::endl;
+    return failures ? 1 : 0;
+    }
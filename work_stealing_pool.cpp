@@ -0,0 +1,116 @@
+
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+
+namespace AnCO {
+
+    work_stealing_pool::work_stealing_pool(unsigned int n_threads) : generation(0), stop(false), pending(0) {
+        n_threads = (std::max)(1u, n_threads);
+        for (unsigned int i = 0; i<n_threads; ++i) {
+            queues.push_back(std::unique_ptr<task_queue>(new task_queue()));
+            }
+        // Queue 0 belongs to the thread calling 'run'
+        for (unsigned int i = 1; i<n_threads; ++i) {
+            threads.push_back(std::thread(&work_stealing_pool::worker, this, i));
+            }
+        }
+
+    work_stealing_pool::~work_stealing_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cv_start.notify_all();
+        for (auto it = threads.begin(); it != threads.end(); ++it) {
+            it->join();
+            }
+        }
+
+    void work_stealing_pool::run(std::vector<_t_task>& tasks) {
+        if (tasks.empty()) {
+            return;
+            }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = nullptr;
+            pending = tasks.size();
+            for (std::size_t i = 0; i<tasks.size(); ++i) {
+                task_queue& q = *queues[i % queues.size()];
+                std::lock_guard<std::mutex> qlock(q.mutex);
+                q.tasks.push_back(&tasks[i]);
+                }
+            ++generation;
+        }
+        cv_start.notify_all();
+
+        this->work(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        cv_done.wait(lock, [this](){ return pending == 0; });
+        if (error) {
+            std::exception_ptr e = error;
+            error = nullptr;
+            std::rethrow_exception(e);
+            }
+        }
+
+    void work_stealing_pool::worker(unsigned int index) {
+        unsigned int seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv_start.wait(lock, [this, seen](){ return stop || generation != seen; });
+                if (stop) {
+                    return;
+                    }
+                seen = generation;
+            }
+            this->work(index);
+            }
+        }
+
+    void work_stealing_pool::work(unsigned int index) {
+        _t_task* task;
+        while ((task = this->pop(index)) || (task = this->steal(index))) {
+            try {
+                (*task)();
+                }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                    }
+                }
+            if (--pending == 0) {
+                std::lock_guard<std::mutex> lock(mutex);
+                cv_done.notify_all();
+                }
+            }
+        }
+
+    work_stealing_pool::_t_task* work_stealing_pool::pop(unsigned int index) {
+        task_queue& q = *queues[index];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) {
+            return nullptr;
+            }
+        _t_task* task = q.tasks.back();
+        q.tasks.pop_back();
+        return task;
+        }
+
+    work_stealing_pool::_t_task* work_stealing_pool::steal(unsigned int index) {
+        for (std::size_t i = 1; i<queues.size(); ++i) {
+            task_queue& q = *queues[(index + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.tasks.empty()) {
+                _t_task* task = q.tasks.front();
+                q.tasks.pop_front();
+                return task;
+                }
+            }
+        return nullptr;
+        }
+
+    }
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace AnCO {
+
+    /*
+    Fixed set of worker threads, each one with its own task deque. Workers pop
+    from the back of their own deque and steal from the front of the others
+    when they run out of work, so a batch of uneven tasks (colonies with
+    different path lengths) is balanced across all cores.
+
+    'run' is a barrier: it returns once every task of the batch has finished.
+    The calling thread works as one more worker while it waits.
+    */
+    class work_stealing_pool {
+        public:
+            typedef std::function<void()> _t_task;
+
+            explicit work_stealing_pool(unsigned int n_threads = std::thread::hardware_concurrency());
+            ~work_stealing_pool();
+
+            // Executes all the tasks and waits for them (rethrows the first exception raised by any of them).
+            void run(std::vector<_t_task>& tasks);
+
+            unsigned int size() const { return static_cast<unsigned int>(queues.size()); };
+
+        protected:
+            struct task_queue {
+                std::mutex mutex;
+                std::deque<_t_task*> tasks;
+                };
+
+            void worker(unsigned int index);
+            void work(unsigned int index);
+            _t_task* pop(unsigned int index);
+            _t_task* steal(unsigned int index);
+
+            std::vector<std::unique_ptr<task_queue>> queues;
+            std::vector<std::thread> threads;
+
+            std::mutex mutex;
+            std::condition_variable cv_start;
+            std::condition_variable cv_done;
+            unsigned int generation;
+            bool stop;
+            std::atomic<std::size_t> pending;
+            std::exception_ptr error;
+
+        private:
+            work_stealing_pool(const work_stealing_pool&);
+            work_stealing_pool& operator=(const work_stealing_pool&);
+        };
+
+    }